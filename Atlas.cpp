@@ -0,0 +1,264 @@
+#include "Atlas.hpp"
+#include "Reader.hpp"
+#include "stb_image.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char ATLAS_MAGIC[8] = {'W', 'F', 'C', 'A', 'T', 'L', 'A', 'S'};
+static const size_t ATLAS_HEADER_BYTES = 8 + 6 * 4 + 8;
+
+static uint32_t read_u32(const unsigned char* p)
+{
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+static void put_u32(std::vector<unsigned char>& out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+}
+
+bool Atlas::open(const std::string& path)
+{
+    close();
+
+#ifdef _WIN32
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        std::cerr << "Error: Could not open atlas: " << path << std::endl;
+        return false;
+    }
+    std::fseek(file, 0, SEEK_END);
+    long length = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    buffer.resize(length > 0 ? static_cast<size_t>(length) : 0);
+    bool read_ok = buffer.empty() || std::fread(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    std::fclose(file);
+    if (!read_ok)
+    {
+        std::cerr << "Error: Could not read atlas: " << path << std::endl;
+        return false;
+    }
+    data = buffer.data();
+    size = buffer.size();
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Error: Could not open atlas: " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        ::close(fd);
+        std::cerr << "Error: Could not read atlas: " << path << std::endl;
+        return false;
+    }
+    size = static_cast<size_t>(st.st_size);
+    mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        mapping = nullptr;
+        size = 0;
+        std::cerr << "Error: Could not map atlas: " << path << std::endl;
+        return false;
+    }
+    data = static_cast<const unsigned char*>(mapping);
+#endif
+
+    // Header
+    if (size < ATLAS_HEADER_BYTES || std::memcmp(data, ATLAS_MAGIC, sizeof(ATLAS_MAGIC)) != 0 ||
+        read_u32(data + 8) != ATLAS_VERSION)
+    {
+        std::cerr << "Error: " << path << " is not a version " << ATLAS_VERSION << " tile atlas" << std::endl;
+        close();
+        return false;
+    }
+    uint32_t tile_count = read_u32(data + 12);
+    tile_width = static_cast<int>(read_u32(data + 16));
+    tile_height = static_cast<int>(read_u32(data + 20));
+    channels = static_cast<int>(read_u32(data + 24));
+    pixel_offset = static_cast<uint64_t>(read_u32(data + 32)) | static_cast<uint64_t>(read_u32(data + 36)) << 32;
+
+    // Tile names
+    size_t cursor = ATLAS_HEADER_BYTES;
+    constraints.reserve(tile_count);
+    loaded.reserve(tile_count);
+    for (uint32_t id = 0; id < tile_count; id++)
+    {
+        if (cursor + 3 > size)
+            break;
+        size_t length = static_cast<size_t>(data[cursor]) | static_cast<size_t>(data[cursor + 1]) << 8;
+        loaded.push_back(data[cursor + 2]);
+        cursor += 3;
+        if (cursor + length > size)
+            break;
+        constraints.emplace_back(reinterpret_cast<const char*>(data + cursor), length);
+        cursor += length;
+    }
+
+    if (constraints.size() != tile_count || pixel_offset < cursor || pixel_offset > size ||
+        (size - pixel_offset) / std::max<size_t>(tile_bytes(), 1) < tile_count)
+    {
+        std::cerr << "Error: Truncated tile atlas: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    std::cout << "Atlas: " << tile_count << " tiles of " << tile_width << "x" << tile_height
+              << " with " << channels << " channels" << std::endl;
+    return true;
+}
+
+void Atlas::close()
+{
+#ifndef _WIN32
+    if (mapping)
+        munmap(mapping, size);
+#endif
+    mapping = nullptr;
+    std::vector<unsigned char>().swap(buffer);
+    data = nullptr;
+    size = 0;
+    pixel_offset = 0;
+    constraints.clear();
+    loaded.clear();
+    tile_width = 0;
+    tile_height = 0;
+    channels = 0;
+}
+
+bool Atlas::decode_tiles(const std::string& folder, const std::vector<std::string>& names,
+                         int& tile_width, int& tile_height, int& channels,
+                         std::vector<unsigned char>& pixels, std::vector<uint8_t>& loaded)
+{
+    tile_width = 0;
+    tile_height = 0;
+    channels = 0;
+    pixels.clear();
+    loaded.assign(names.size(), 0);
+
+    // Load first tile to get dimensions
+    if (names.empty())
+        return false;
+    std::string first_tile_path = folder + "/" + names[0] + ".png";
+    unsigned char* first = stbi_load(first_tile_path.c_str(), &tile_width, &tile_height, &channels, 0);
+    if (!first)
+    {
+        std::cerr << "Error: Could not load tile image: " << first_tile_path << std::endl;
+        return false;
+    }
+    stbi_image_free(first);
+    std::cout << "Tile dimensions: " << tile_width << "x" << tile_height << " with " << channels << " channels" << std::endl;
+
+    size_t tile_bytes = static_cast<size_t>(tile_width) * tile_height * channels;
+    pixels.assign(tile_bytes * names.size(), 0);
+    for (size_t id = 0; id < names.size(); id++)
+    {
+        std::string tile_path = folder + "/" + names[id] + ".png";
+        int loaded_width, loaded_height, loaded_channels;
+        unsigned char* tile_data = stbi_load(tile_path.c_str(), &loaded_width, &loaded_height, &loaded_channels, channels);
+        if (!tile_data)
+        {
+            std::cerr << "Warning: Could not load tile image: " << tile_path << std::endl;
+            continue;
+        }
+
+        unsigned char* target = pixels.data() + id * tile_bytes;
+        size_t copy = static_cast<size_t>(std::min(tile_width, loaded_width)) * channels;
+        for (int y = 0; y < tile_height && y < loaded_height; y++)
+        {
+            std::memcpy(target + static_cast<size_t>(y) * tile_width * channels,
+                        tile_data + static_cast<size_t>(y) * loaded_width * channels, copy);
+        }
+        stbi_image_free(tile_data);
+        loaded[id] = 1;
+    }
+    return true;
+}
+
+bool Atlas::pack(const std::string& folder, const std::string& output_path)
+{
+    Reader reader;
+    reader.read_files(folder);
+
+    int width, height, chans;
+    std::vector<unsigned char> pixels;
+    std::vector<uint8_t> tile_loaded;
+    if (!decode_tiles(folder, reader.constraints, width, height, chans, pixels, tile_loaded))
+        return false;
+
+    std::vector<unsigned char> header(ATLAS_MAGIC, ATLAS_MAGIC + sizeof(ATLAS_MAGIC));
+    put_u32(header, ATLAS_VERSION);
+    put_u32(header, static_cast<uint32_t>(reader.constraints.size()));
+    put_u32(header, static_cast<uint32_t>(width));
+    put_u32(header, static_cast<uint32_t>(height));
+    put_u32(header, static_cast<uint32_t>(chans));
+    put_u32(header, 0);
+    size_t offset_field = header.size();
+    put_u32(header, 0);
+    put_u32(header, 0);
+
+    for (size_t id = 0; id < reader.constraints.size(); id++)
+    {
+        const std::string& name = reader.constraints[id];
+        size_t length = std::min<size_t>(name.size(), UINT16_MAX);
+        header.push_back(static_cast<unsigned char>(length));
+        header.push_back(static_cast<unsigned char>(length >> 8));
+        header.push_back(tile_loaded[id]);
+        header.insert(header.end(), name.begin(), name.begin() + length);
+    }
+
+    // Pixels start on a cache line so mapped tiles are aligned like freshly allocated ones
+    header.resize((header.size() + 63) / 64 * 64, 0);
+    uint64_t offset = header.size();
+    for (int i = 0; i < 8; i++)
+        header[offset_field + i] = static_cast<unsigned char>(offset >> (8 * i));
+
+    std::FILE* file = std::fopen(output_path.c_str(), "wb");
+    if (!file)
+    {
+        std::cerr << "Error: Could not open " << output_path << " for writing" << std::endl;
+        return false;
+    }
+    bool success = std::fwrite(header.data(), 1, header.size(), file) == header.size() &&
+                   std::fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+    success = std::fclose(file) == 0 && success;
+    if (!success)
+    {
+        std::cerr << "Error: Failed to write atlas: " << output_path << std::endl;
+        return false;
+    }
+
+    std::cout << "Packed " << reader.constraints.size() << " tiles from " << folder << " into " << output_path
+              << " (" << (header.size() + pixels.size()) / 1024 << " KB)" << std::endl;
+    return true;
+}
+
+Atlas::Atlas()
+{
+    data = nullptr;
+    size = 0;
+    pixel_offset = 0;
+    mapping = nullptr;
+    tile_width = 0;
+    tile_height = 0;
+    channels = 0;
+}
+
+Atlas::~Atlas()
+{
+    close();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Packed tileset: the constraints of every tile in a fixed (sorted) order plus
+// their decoded pixels, all padded to a common size, in one file. Written by
+// pack_atlas and memory mapped on load, so a run neither scans a folder nor
+// decodes a PNG and the renderer blits straight from the mapping.
+//
+// Layout (little endian):
+//   char     magic[8]      "WFCATLAS"
+//   uint32_t version       ATLAS_VERSION
+//   uint32_t tile_count, tile_width, tile_height, channels
+//   uint32_t reserved
+//   uint64_t pixel_offset  start of the pixel block, 64-byte aligned
+//   per tile: uint16_t name length, uint8_t loaded, name bytes
+//   pixels: tile_count x tile_height x tile_width x channels
+class Atlas
+{
+private:
+    const unsigned char* data;  // Whole file
+    size_t size;
+    uint64_t pixel_offset;
+    std::vector<unsigned char> buffer; // File contents when mmap is not available
+    void* mapping;
+
+public:
+    static const uint32_t ATLAS_VERSION = 1;
+
+    std::vector<std::string> constraints; // Tile names (NSEW edge labels) by tile id
+    std::vector<uint8_t> loaded;          // 0 when the tile image could not be decoded when packing
+    int tile_width;
+    int tile_height;
+    int channels;
+
+    bool open(const std::string& path);
+    void close();
+    size_t tile_bytes() const { return static_cast<size_t>(tile_width) * tile_height * channels; }
+    const unsigned char* tile_pixels(int id) const { return data + pixel_offset + id * tile_bytes(); }
+
+    // Decodes folder/name.png for every name into pixels (tile after tile), converted to the
+    // channel count of the first tile and padded with black to its size. False when the
+    // first tile cannot be read, in which case nothing is decoded
+    static bool decode_tiles(const std::string& folder, const std::vector<std::string>& names,
+                             int& tile_width, int& tile_height, int& channels,
+                             std::vector<unsigned char>& pixels, std::vector<uint8_t>& loaded);
+    static bool pack(const std::string& folder, const std::string& output_path);
+
+    Atlas();
+    ~Atlas();
+    Atlas(const Atlas&) = delete;
+    Atlas& operator=(const Atlas&) = delete;
+};
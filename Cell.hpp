@@ -2,6 +2,7 @@
 
 #include <vector>
 #include "Tile.hpp"
+#include "Domain.hpp"
 
 class Cell
 {
@@ -9,11 +10,11 @@ private:
     
 public:
     int collapsed;
-    std::vector<Tile> domain;
+    Domain domain;
 
     void print_domain(void);
     void print_domain_size(void);
     size_t get_memory_usage() const;
     Cell();
     ~Cell();
-};
\ No newline at end of file
+};
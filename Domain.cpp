@@ -0,0 +1,40 @@
+#include "Domain.hpp"
+
+void Domain::fill(int num_tiles)
+{
+    bits.assign(domain_words(num_tiles), ~uint64_t(0));
+    if (num_tiles % 64 != 0)
+    {
+        bits.back() = (uint64_t(1) << (num_tiles % 64)) - 1; // Keep padding bits clear
+    }
+}
+
+void Domain::reset(int num_tiles)
+{
+    bits.assign(domain_words(num_tiles), 0);
+}
+
+void Domain::assign_single(int tile)
+{
+    clear();
+    add(tile);
+}
+
+void Domain::print(void) const
+{
+    for_each([](int tile) { std::cout << tile << " "; });
+    std::cout << std::endl;
+}
+
+size_t Domain::get_memory_usage() const
+{
+    return sizeof(*this) + bits.capacity() * sizeof(uint64_t);
+}
+
+Domain::Domain()
+{
+}
+
+Domain::~Domain()
+{
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Raw word helpers, shared by Domain and any code storing domain words directly.
+// A domain holds one bit per tile: bit (t % 64) of word (t / 64) is set when tile t is allowed.
+
+inline int domain_words(int num_tiles)
+{
+    return (num_tiles + 63) / 64;
+}
+
+inline int popcount64(uint64_t word)
+{
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(word));
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+inline int lowest_bit64(uint64_t word)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+// dst &= mask, returns true when any bit was cleared
+inline bool bits_and(uint64_t* dst, const uint64_t* mask, int words)
+{
+    uint64_t removed = 0;
+    for (int w = 0; w < words; w++)
+    {
+        removed |= dst[w] & ~mask[w];
+        dst[w] &= mask[w];
+    }
+    return removed != 0;
+}
+
+inline void bits_or(uint64_t* dst, const uint64_t* src, int words)
+{
+    for (int w = 0; w < words; w++)
+    {
+        dst[w] |= src[w];
+    }
+}
+
+inline int bits_count(const uint64_t* bits, int words)
+{
+    int count = 0;
+    for (int w = 0; w < words; w++)
+    {
+        count += popcount64(bits[w]);
+    }
+    return count;
+}
+
+// Index of the n-th set bit (0-based, ascending tile order), -1 if there are not enough bits
+inline int bits_nth(const uint64_t* bits, int words, int n)
+{
+    for (int w = 0; w < words; w++)
+    {
+        uint64_t word = bits[w];
+        int count = popcount64(word);
+        if (n < count)
+        {
+            for (int k = 0; k < n; k++)
+            {
+                word &= word - 1; // Drop lowest set bit
+            }
+            return w * 64 + lowest_bit64(word);
+        }
+        n -= count;
+    }
+    return -1;
+}
+
+// Calls f(tile) for every set bit in ascending order
+template <typename F>
+inline void bits_for_each(const uint64_t* bits, int words, F f)
+{
+    for (int w = 0; w < words; w++)
+    {
+        uint64_t word = bits[w];
+        while (word)
+        {
+            f(w * 64 + lowest_bit64(word));
+            word &= word - 1;
+        }
+    }
+}
+
+// Set of tiles still allowed in a cell, one bit per tile of the tileset
+class Domain
+{
+private:
+    
+public:
+    std::vector<uint64_t> bits;
+
+    void fill(int num_tiles);   // Every tile allowed
+    void reset(int num_tiles);  // No tile allowed, sized for num_tiles
+    void assign_single(int tile);
+    void print(void) const;
+    size_t get_memory_usage() const;
+    Domain();
+    ~Domain();
+
+    int words() const { return static_cast<int>(bits.size()); }
+    int size() const { return bits_count(bits.data(), words()); }
+    bool empty() const
+    {
+        for (uint64_t word : bits)
+        {
+            if (word) return false;
+        }
+        return true;
+    }
+    bool contains(int tile) const { return (bits[tile >> 6] >> (tile & 63)) & 1; }
+    void add(int tile) { bits[tile >> 6] |= uint64_t(1) << (tile & 63); }
+    void remove(int tile) { bits[tile >> 6] &= ~(uint64_t(1) << (tile & 63)); }
+    void clear() { std::fill(bits.begin(), bits.end(), 0); }
+    int nth(int n) const { return bits_nth(bits.data(), words(), n); }
+    bool intersect(const Domain& mask) { return bits_and(bits.data(), mask.bits.data(), words()); }
+    void unite(const Domain& other) { bits_or(bits.data(), other.bits.data(), words()); }
+
+    template <typename F>
+    void for_each(F f) const { bits_for_each(bits.data(), words(), f); }
+};
@@ -0,0 +1,153 @@
+#include "EntropyQueue.hpp"
+#include <algorithm>
+
+void EntropyQueue::enable(const Matrix& matrix)
+{
+    enabled = true;
+
+    int max_size = 0;
+    for (auto size : matrix.domain_sizes)
+    {
+        max_size = std::max<int>(max_size, size);
+    }
+
+    buckets.assign(max_size + 1, std::vector<uint32_t>());
+    position.assign(matrix.cells(), -1);
+    bucket_of.assign(matrix.cells(), 0);
+    min_bucket = max_size + 1;
+
+    for (size_t idx = 0; idx < matrix.cells(); idx++)
+    {
+        if (matrix.collapsed[idx] == -1)
+        {
+            insert(idx, matrix.domain_sizes[idx]);
+        }
+    }
+}
+
+void EntropyQueue::disable(void)
+{
+    enabled = false;
+    buckets.clear();
+    position.clear();
+    bucket_of.clear();
+    restored.clear();
+}
+
+void EntropyQueue::restore(size_t idx)
+{
+    if (enabled)
+        restored.push_back(static_cast<uint32_t>(idx));
+}
+
+void EntropyQueue::finish_restore(const Matrix& matrix)
+{
+    if (!enabled)
+        return;
+
+    // The trail order depends on how propagation reached each cell. Taking the cells out and
+    // queueing them back by index leaves the buckets, and so pick, independent of it
+    std::sort(restored.begin(), restored.end());
+    restored.erase(std::unique(restored.begin(), restored.end()), restored.end());
+    for (uint32_t idx : restored)
+    {
+        remove(idx);
+    }
+    for (uint32_t idx : restored)
+    {
+        if (matrix.collapsed[idx] == -1)
+            insert(idx, matrix.domain_sizes[idx]);
+    }
+    restored.clear();
+}
+
+void EntropyQueue::insert(size_t idx, int size)
+{
+    if (size >= static_cast<int>(buckets.size()))
+    {
+        buckets.resize(size + 1);
+    }
+
+    position[idx] = static_cast<int32_t>(buckets[size].size());
+    bucket_of[idx] = static_cast<uint16_t>(size);
+    buckets[size].push_back(static_cast<uint32_t>(idx));
+
+    if (size >= 1 && size < min_bucket)
+    {
+        min_bucket = size;
+    }
+}
+
+void EntropyQueue::remove(size_t idx)
+{
+    if (!enabled || position[idx] < 0)
+        return;
+
+    // Swap-remove from the bucket
+    auto& bucket = buckets[bucket_of[idx]];
+    uint32_t last = bucket.back();
+    bucket[position[idx]] = last;
+    position[last] = position[idx];
+    bucket.pop_back();
+    position[idx] = -1;
+}
+
+void EntropyQueue::update(size_t idx, int size)
+{
+    if (!enabled || position[idx] < 0 || bucket_of[idx] == size)
+        return;
+
+    remove(idx);
+    insert(idx, size);
+}
+
+bool EntropyQueue::has_contradiction() const
+{
+    return enabled && !buckets.empty() && !buckets[0].empty();
+}
+
+long long EntropyQueue::pick(std::mt19937& rng)
+{
+    // min_bucket is a lower bound kept by insert, skip buckets that drained since
+    while (min_bucket < static_cast<int>(buckets.size()) && buckets[min_bucket].empty())
+    {
+        min_bucket++;
+    }
+
+    if (min_bucket >= static_cast<int>(buckets.size()))
+        return -1; // Every cell is collapsed
+
+    // Random tie-breaking among the cells with minimum entropy
+    const auto& bucket = buckets[min_bucket];
+    std::uniform_int_distribution<std::size_t> dist(0, bucket.size() - 1);
+    return bucket[dist(rng)];
+}
+
+bool EntropyQueue::is_enabled() const
+{
+    return enabled;
+}
+
+size_t EntropyQueue::get_memory_usage() const
+{
+    size_t size = sizeof(*this);
+    size += buckets.capacity() * sizeof(std::vector<uint32_t>);
+    for (const auto& bucket : buckets)
+    {
+        size += bucket.capacity() * sizeof(uint32_t);
+    }
+    size += position.capacity() * sizeof(int32_t);
+    size += bucket_of.capacity() * sizeof(uint16_t);
+    size += restored.capacity() * sizeof(uint32_t);
+    return size;
+}
+
+EntropyQueue::EntropyQueue()
+{
+    min_bucket = 0;
+    enabled = false;
+}
+
+EntropyQueue::~EntropyQueue()
+{
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <random>
+#include <vector>
+#include <cstdint>
+#include "Matrix.hpp"
+
+// Uncollapsed cells bucketed by domain size, kept up to date by WFC::propagate
+// so MRV can pick the next cell without rescanning the grid.
+// Bucket 0 holds cells whose domain was wiped out (contradictions).
+class EntropyQueue
+{
+private:
+    std::vector<std::vector<uint32_t>> buckets; // buckets[s]: cells with domain size s
+    std::vector<int32_t> position;              // Slot of each cell in its bucket, -1 when not queued
+    std::vector<uint16_t> bucket_of;            // Bucket each queued cell is in
+    std::vector<uint32_t> restored;             // Cells touched by the rollback in progress
+    int min_bucket;                             // No non-empty bucket >= 1 lies below this
+    bool enabled;
+
+    void insert(size_t idx, int size);
+
+public:
+    void enable(const Matrix& matrix);  // Queue every uncollapsed cell of the matrix
+    void disable(void);
+    void restore(size_t idx);                   // Cell changed in a trail rollback
+    void finish_restore(const Matrix& matrix);  // Re-sync the restored cells, in index order
+    void update(size_t idx, int size);  // Domain of a queued cell shrank or grew to size
+    void remove(size_t idx);            // Cell was collapsed
+    bool has_contradiction() const;
+    long long pick(std::mt19937& rng);  // Random cell among the smallest domains, -1 if none left
+    bool is_enabled() const;
+    size_t get_memory_usage() const;
+    EntropyQueue();
+    ~EntropyQueue();
+};
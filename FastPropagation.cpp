@@ -1,23 +1,78 @@
 #include "FastPropagation.hpp"
+#include "ThreadPool.hpp"
 #include <iostream>
 #include <algorithm>
 
-void FastPropagation::initialize_fp(int rows, int columns, Cell c, unsigned int seed)
+// Cells per side of the blocks scheduled by DiagParallel
+static const int PARALLEL_BLOCK = 64;
+
+// Stateless random stream: the value for a cell depends only on the seed and its position,
+// never on the order cells are visited in (splitmix64 finalizer)
+static inline uint64_t cell_random(uint64_t seed, uint64_t idx)
+{
+    uint64_t z = seed + (idx + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void FastPropagation::initialize_fp(int rows, int columns, Cell c, const Tileset& tileset, unsigned int seed)
 {
     this->rows = rows;
     this->columns = columns;
+    this->tileset = &tileset;
+    this->seed = seed;
     rng.seed(seed);
     matrix.initialize_matrix(rows, columns, c);
+    matrix.trail = nullptr;
+    trail.clear();
     backtrack_count = 0; // Initialize counter
     backtrack_memory_cost = 0; // Initialize memory cost
 }
 
+void FastPropagation::initialize_fp_table(int rows, int columns, const Tileset& tileset, unsigned int seed)
+{
+    this->rows = rows;
+    this->columns = columns;
+    this->tileset = &tileset;
+    this->seed = seed;
+    rng.seed(seed);
+    matrix.initialize_ids(rows, columns); // The table engine keeps no domains
+    matrix.trail = nullptr;
+    trail.clear();
+    backtrack_count = 0;
+    backtrack_memory_cost = 0;
+}
+
+void FastPropagation::initialize_fp_stream(int rows, int columns, const Tileset& tileset, unsigned int seed)
+{
+    this->rows = rows;
+    this->columns = columns;
+    this->tileset = &tileset;
+    this->seed = seed;
+    rng.seed(seed);
+    matrix.initialize_ids(0, 0); // Rows only live in the ring buffer
+    matrix.trail = nullptr;
+    trail.clear();
+    row_ring.assign(2 * static_cast<size_t>(columns), -1);
+    backtrack_count = 0;
+    backtrack_memory_cost = 0;
+}
+
 void FastPropagation::run(std::string heuristic)
 {
     if (heuristic == "FP")
     {
         FP(false);
     }
+    else if (heuristic == "Table")
+    {
+        Table();
+    }
+    else if (heuristic == "DiagonalParallel")
+    {
+        DiagParallel();
+    }
     else if (heuristic == "Diagonal")
     {
         Diag();
@@ -26,6 +81,9 @@ void FastPropagation::run(std::string heuristic)
 
 void FastPropagation::FP(bool backtrack)
 {
+    // Only log domain changes when they may have to be undone
+    matrix.trail = backtrack ? &trail : nullptr;
+
     for (int i = 0; i < rows; i++)
     {
         for (int j = 0; j < columns; j++)
@@ -54,13 +112,13 @@ void FastPropagation::FP(bool backtrack)
                 }
                 
                 // Propagate constraints
-                propagate(i, j);
+                PropagationResult result = propagate(i, j);
                 
-                if (backtrack && has_empty_domains()) {
-                    // If propagation caused empty domains, we need to backtrack
+                if (backtrack && result.contradiction) {
+                    // If propagation wiped out a domain, we need to backtrack
                     success = false;
                     if (!backtrack_restore()) {
-                        std::cerr << "Error: Unable to solve - propagation caused unsolvable state at (" << i << "," << j << ")" << std::endl;
+                        std::cerr << "Error: Unable to solve - propagation caused unsolvable state at (" << i << "," << j << "), domain wiped out at (" << result.row << "," << result.col << ")" << std::endl;
                         return;
                     }
                 } else {
@@ -71,6 +129,114 @@ void FastPropagation::FP(bool backtrack)
     }
 }
 
+void FastPropagation::Table()
+{
+    // Same order and random picks as FP(false), but the domain of (i,j) is looked up from the
+    // south label above and the east label to the left instead of being kept per cell
+    int* ids = matrix.collapsed.data();
+    for (int i = 0; i < rows; i++)
+    {
+        int* row = ids + static_cast<size_t>(i) * columns;
+        table_row(row, i > 0 ? row - columns : nullptr);
+    }
+}
+
+void FastPropagation::Stream(const std::function<void(int row, const int* ids)>& sink)
+{
+    // FP never looks further back than the previous row: keep two rows and hand each one
+    // to the sink as soon as it is done. Same picks as Table(), so the same grid as FP.
+    for (int i = 0; i < rows; i++)
+    {
+        int* row = row_ring.data() + static_cast<size_t>(i & 1) * columns;
+        const int* above = i > 0 ? row_ring.data() + static_cast<size_t>((i - 1) & 1) * columns : nullptr;
+        std::fill(row, row + columns, -1);
+        table_row(row, above);
+        sink(i, row);
+    }
+}
+
+void FastPropagation::table_row(int* row, const int* above)
+{
+    // An uncollapsed neighbour constrains nothing, like a skipped propagate in FP
+    const int any = tileset->num_labels;
+    const Tile* tiles = tileset->tiles.data();
+
+    for (int j = 0; j < columns; j++)
+    {
+        int north = (above && above[j] != -1) ? tiles[above[j]].south : any;
+        int west = (j > 0 && row[j - 1] != -1) ? tiles[row[j - 1]].east : any;
+
+        int count;
+        const uint16_t* list = tileset->candidates_for(north, west, count);
+        if (count == 0)
+            continue; // Contradiction: the cell stays uncollapsed
+
+        std::uniform_int_distribution<std::size_t> dist(0, count - 1);
+        row[j] = list[dist(rng)];
+    }
+}
+
+void FastPropagation::set_threads(int threads)
+{
+    this->threads = threads;
+}
+
+void FastPropagation::DiagParallel()
+{
+    // Each cell pulls its constraints from the tiles above and to the left, which are final
+    // once the previous anti-diagonal is done, so no two cells ever write the same target.
+    // Cells are grouped in square blocks and the blocks are swept by anti-diagonal: every
+    // block on one diagonal only reads blocks of earlier diagonals and runs in parallel.
+    // With per-cell random streams the grid is the same for any thread count.
+    ThreadPool pool(threads);
+
+    int block_rows = (rows + PARALLEL_BLOCK - 1) / PARALLEL_BLOCK;
+    int block_cols = (columns + PARALLEL_BLOCK - 1) / PARALLEL_BLOCK;
+
+    for (int diagonal = 0; diagonal < block_rows + block_cols - 1; ++diagonal)
+    {
+        int start_row = std::max(0, diagonal - block_cols + 1);
+        int end_row = std::min(block_rows - 1, diagonal);
+
+        pool.parallel_for(end_row - start_row + 1, [&](size_t k) {
+            int block_row = start_row + static_cast<int>(k);
+            int block_col = diagonal - block_row;
+            int first_row = block_row * PARALLEL_BLOCK;
+            int first_col = block_col * PARALLEL_BLOCK;
+            fill_block(first_row, first_col,
+                       std::min(rows, first_row + PARALLEL_BLOCK), std::min(columns, first_col + PARALLEL_BLOCK));
+        });
+    }
+}
+
+void FastPropagation::fill_block(int first_row, int first_col, int last_row, int last_col)
+{
+    const int any = tileset->num_labels;
+    const Tile* tiles = tileset->tiles.data();
+    int* ids = matrix.collapsed.data();
+
+    for (int i = first_row; i < last_row; i++)
+    {
+        int* row = ids + static_cast<size_t>(i) * columns;
+        const int* above = i > 0 ? row - columns : nullptr;
+
+        for (int j = first_col; j < last_col; j++)
+        {
+            int north = (above && above[j] != -1) ? tiles[above[j]].south : any;
+            int west = (j > 0 && row[j - 1] != -1) ? tiles[row[j - 1]].east : any;
+
+            int count;
+            const uint16_t* list = tileset->candidates_for(north, west, count);
+            if (count == 0)
+                continue; // Contradiction: the cell stays uncollapsed
+
+            // Multiply-shift maps the high 32 bits onto [0, count)
+            uint64_t r = cell_random(seed, static_cast<uint64_t>(i) * columns + j) >> 32;
+            row[j] = list[(r * static_cast<uint64_t>(count)) >> 32];
+        }
+    }
+}
+
 void FastPropagation::Diag()
 {
     // Anti-diagonais: (0,0) -> (0,1), (1,0) -> (0,2), (1,1), (2,0) -> etc.
@@ -95,6 +261,8 @@ void FastPropagation::Diag()
 
 void FastPropagation::Diag(bool backtrack)
 {
+    matrix.trail = backtrack ? &trail : nullptr;
+
     // Anti-diagonais: (0,0) -> (0,1), (1,0) -> (0,2), (1,1), (2,0) -> etc.
     for (int diagonal = 0; diagonal < rows + columns - 1; ++diagonal)
     {
@@ -132,13 +300,13 @@ void FastPropagation::Diag(bool backtrack)
                     }
                     
                     // Propagate constraints
-                    propagate(row, col);
+                    PropagationResult result = propagate(row, col);
                     
-                    if (backtrack && has_empty_domains()) {
-                        // If propagation caused empty domains, we need to backtrack
+                    if (backtrack && result.contradiction) {
+                        // If propagation wiped out a domain, we need to backtrack
                         success = false;
                         if (!backtrack_restore()) {
-                            std::cerr << "Error: Unable to solve - propagation caused unsolvable state at (" << row << "," << col << ")" << std::endl;
+                            std::cerr << "Error: Unable to solve - propagation caused unsolvable state at (" << row << "," << col << "), domain wiped out at (" << result.row << "," << result.col << ")" << std::endl;
                             return;
                         }
                     } else {
@@ -152,49 +320,53 @@ void FastPropagation::Diag(bool backtrack)
 
 void FastPropagation::collapse(int i, int j)
 {
-    int size = matrix.matrix[i][j].domain.size();
+    size_t idx = matrix.index(i, j);
+    int size = matrix.domain_sizes[idx];
+    if (size == 0)
+        return; // Contradiction: nothing to pick, the cell stays uncollapsed
+
     std::uniform_int_distribution<std::size_t> dist(0, size - 1);
     int choice = dist(rng);
 
-    Tile pickedValue = matrix.matrix[i][j].domain[choice];
-    matrix.matrix[i][j].domain.clear();
-    matrix.matrix[i][j].domain.push_back(pickedValue);
-    matrix.matrix[i][j].collapsed = std::stoi(pickedValue.id);
+    int picked = bits_nth(matrix.domain(idx), matrix.words, choice);
+    matrix.assign_single(idx, picked);
 }
 
-void FastPropagation::propagate(int i, int j)
+PropagationResult FastPropagation::propagate(int i, int j)
 {
-    Tile selected = matrix.matrix[i][j].domain[0]; // Tile that is collapsed
+    PropagationResult result = { false, -1, -1 };
+
+    size_t idx = matrix.index(i, j);
+    int selected = matrix.collapsed[idx]; // Tile that is collapsed
+    if (selected == -1)
+        return result; // Empty domain left the cell uncollapsed, it constrains nothing
 
     if(i + 1 < rows) // Can remove NORTH
     {
-        std::vector<Tile> remaining;
-        for (auto & tile : matrix.matrix[i+1][j].domain)
+        size_t below = idx + columns;
+        if (matrix.restrict_domain(below, tileset->allowed_mask[SOUTH][selected].bits.data()) && matrix.domain_sizes[below] == 0)
         {
-            if (selected.south == tile.north)
-            {
-                remaining.push_back(tile);
-            }
+            result = { true, i + 1, j };
         }
-        matrix.matrix[i + 1][j].domain = std::move(remaining);
     }
 
     if (j + 1 < columns)  // Can remove WEST
     {
-        std::vector<Tile> remaining;
-        for (auto &tile : matrix.matrix[i][j+1].domain)
+        size_t right = idx + 1;
+        if (matrix.restrict_domain(right, tileset->allowed_mask[EAST][selected].bits.data()) && matrix.domain_sizes[right] == 0 && !result.contradiction)
         {
-            if (selected.east == tile.west)
-            {
-                remaining.push_back(tile);
-            }
+            result = { true, i, j + 1 };
         }
-        matrix.matrix[i][j+1].domain = std::move(remaining);
     }
+
+    return result;
 }
 
 FastPropagation::FastPropagation(/* args */)
 {
+    tileset = nullptr;
+    seed = 0;
+    threads = 0;
     backtrack_count = 0;
     backtrack_memory_cost = 0;
 }
@@ -205,33 +377,30 @@ FastPropagation::~FastPropagation()
 
 bool FastPropagation::collapse_with_backtrack(int i, int j, const std::vector<int>& tried_tiles)
 {
-    std::vector<Tile> available_tiles;
+    size_t idx = matrix.index(i, j);
+    Domain available_tiles = matrix.get_domain(idx);
     
     // Filter out tiles we've already tried
-    for (const auto& tile : matrix.matrix[i][j].domain) {
-        int tile_id = std::stoi(tile.id);
-        if (std::find(tried_tiles.begin(), tried_tiles.end(), tile_id) == tried_tiles.end()) {
-            available_tiles.push_back(tile);
-        }
+    for (int tile_id : tried_tiles) {
+        available_tiles.remove(tile_id);
     }
     
-    if (available_tiles.empty()) {
+    int available_count = available_tiles.size();
+    if (available_count == 0) {
         return false; // No more tiles to try
     }
     
     // Select a random tile from available ones
-    std::uniform_int_distribution<std::size_t> dist(0, available_tiles.size() - 1);
+    std::uniform_int_distribution<std::size_t> dist(0, available_count - 1);
     int choice = dist(rng);
     
-    Tile pickedValue = available_tiles[choice];
-    matrix.matrix[i][j].domain.clear();
-    matrix.matrix[i][j].domain.push_back(pickedValue);
-    matrix.matrix[i][j].collapsed = std::stoi(pickedValue.id);
+    int picked = available_tiles.nth(choice);
+    matrix.assign_single(idx, picked);
     
     // Update the state with the tile we just tried
     if (!state_stack.empty()) {
-        state_stack.top().collapsed_tile_id = std::stoi(pickedValue.id);
-        state_stack.top().tried_tiles.push_back(std::stoi(pickedValue.id));
+        state_stack.top().collapsed_tile_id = picked;
+        state_stack.top().tried_tiles.push_back(picked);
     }
     
     return true;
@@ -239,11 +408,10 @@ bool FastPropagation::collapse_with_backtrack(int i, int j, const std::vector<in
 
 bool FastPropagation::has_empty_domains()
 {
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < columns; j++) {
-            if (matrix.matrix[i][j].collapsed == -1 && matrix.matrix[i][j].domain.empty()) {
-                return true;
-            }
+    size_t cell_count = matrix.cells();
+    for (size_t idx = 0; idx < cell_count; idx++) {
+        if (matrix.collapsed[idx] == -1 && matrix.domain_sizes[idx] == 0) {
+            return true;
         }
     }
     return false;
@@ -251,16 +419,20 @@ bool FastPropagation::has_empty_domains()
 
 void FastPropagation::save_state(int i, int j, int collapsed_tile_id)
 {
+    // Nothing below the oldest saved state can be undone, drop it
+    if (state_stack.empty()) {
+        trail.clear();
+    }
+    
     BacktrackState state;
-    state.matrix_state = matrix; // Use copy constructor
+    state.trail_mark = trail.mark(); // Changes after this point are undone on restore
     state.row = i;
     state.col = j;
     state.collapsed_tile_id = collapsed_tile_id;
     state.tried_tiles.clear();
     
     // Calculate memory cost of this state save
-    size_t state_memory = sizeof(BacktrackState) + state.matrix_state.get_memory_usage() + 
-                         (state.tried_tiles.capacity() * sizeof(int));
+    size_t state_memory = sizeof(BacktrackState) + (state.tried_tiles.capacity() * sizeof(int));
     backtrack_memory_cost += state_memory;
     
     state_stack.push(state);
@@ -277,27 +449,24 @@ bool FastPropagation::backtrack_restore()
     BacktrackState current_state = state_stack.top();
     state_stack.pop();
     
+    // Undo every change made since the state was saved
+    matrix.rollback(current_state.trail_mark, [](size_t, int, uint64_t) {});
+    
     // Check if we have more tiles to try at this position
-    std::vector<Tile> available_tiles;
-    for (const auto& tile : current_state.matrix_state.matrix[current_state.row][current_state.col].domain) {
-        int tile_id = std::stoi(tile.id);
-        if (std::find(current_state.tried_tiles.begin(), current_state.tried_tiles.end(), tile_id) == current_state.tried_tiles.end()) {
-            available_tiles.push_back(tile);
-        }
+    Domain available_tiles = matrix.get_domain(matrix.index(current_state.row, current_state.col));
+    for (int tile_id : current_state.tried_tiles) {
+        available_tiles.remove(tile_id);
     }
     
     if (!available_tiles.empty()) {
-        // We have more tiles to try, restore state and update tried_tiles
-        matrix = current_state.matrix_state;
-        
+        // We have more tiles to try, state is restored, update tried_tiles
         // Put the state back with updated tried_tiles for next attempt
         state_stack.push(current_state);
         
         // Try to collapse with the updated tried_tiles list
         return collapse_with_backtrack(current_state.row, current_state.col, current_state.tried_tiles);
     } else {
-        // No more tiles to try at this position, restore state and continue backtracking
-        matrix = current_state.matrix_state;
+        // No more tiles to try at this position, continue backtracking
         return backtrack_restore(); // Recursive backtrack
     }
 }
@@ -332,18 +501,11 @@ size_t FastPropagation::get_matrix_memory_usage() const
 
 size_t FastPropagation::get_backtrack_stack_memory_usage() const
 {
-    if (state_stack.empty()) {
-        return sizeof(state_stack); // Just the empty stack container
-    }
-    
     size_t size = sizeof(state_stack); // Stack container itself
     
-    // Each BacktrackState contains a matrix copy, so we estimate the memory per state
-    // This is an approximation since we can't iterate through std::stack
-    size_t matrix_memory = matrix.get_memory_usage();
-    size_t per_state_size = sizeof(BacktrackState) + matrix_memory;
-    
-    size += state_stack.size() * per_state_size;
+    // Saved states are fixed-size markers, the undo data lives in the trail
+    size += state_stack.size() * sizeof(BacktrackState);
+    size += trail.get_memory_usage();
     
     return size;
 }
@@ -364,5 +526,8 @@ size_t FastPropagation::get_memory_usage() const
     // Random number generator (minimal)
     size += sizeof(rng);
     
+    // Streaming ring buffer
+    size += row_ring.capacity() * sizeof(int);
+    
     return size;
 }
\ No newline at end of file
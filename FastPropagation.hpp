@@ -2,10 +2,12 @@
 
 #include <random>
 #include <stack>
+#include <functional>
 #include "Matrix.hpp"
+#include "Tileset.hpp"
 
 struct BacktrackState {
-    Matrix matrix_state;
+    size_t trail_mark; // Trail size when the state was saved
     int row;
     int col;
     int collapsed_tile_id;
@@ -18,21 +20,36 @@ private:
     std::stack<BacktrackState> state_stack;
     int backtrack_count;
     size_t backtrack_memory_cost; // Total memory cost of all backtrack operations
+    Trail trail; // Domain changes since the oldest saved state
+    unsigned int seed; // Base of the per-cell random streams of DiagParallel
+    int threads; // Threads used by DiagParallel, <= 0 for every hardware thread
+
+    std::vector<int> row_ring; // Two-row ring buffer of Stream
+
+    void fill_block(int first_row, int first_col, int last_row, int last_col);
+    void table_row(int* row, const int* above);
     
 public:
     int rows;
     int columns;
     Matrix matrix;
+    const Tileset* tileset;
     std::mt19937 rng;
 
-    void initialize_fp(int rows, int columns, Cell c, unsigned int seed);
+    void initialize_fp(int rows, int columns, Cell c, const Tileset& tileset, unsigned int seed);
+    void initialize_fp_table(int rows, int columns, const Tileset& tileset, unsigned int seed);
+    void initialize_fp_stream(int rows, int columns, const Tileset& tileset, unsigned int seed);
     void run(std::string heuristic);
     void FP(bool backtrack);
+    void Table();
+    void DiagParallel();
+    void Stream(const std::function<void(int row, const int* ids)>& sink); // Emits each finished row, O(columns) memory
+    void set_threads(int threads);
     void Diag();
     void Diag(bool backtrack);
     void collapse(int i, int j);
     bool collapse_with_backtrack(int i, int j, const std::vector<int>& tried_tiles = {});
-    void propagate(int i, int j);
+    PropagationResult propagate(int i, int j);
     bool has_empty_domains();
     void save_state(int i, int j, int collapsed_tile_id);
     bool backtrack_restore();
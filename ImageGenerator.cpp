@@ -1,35 +1,47 @@
 #include "ImageGenerator.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cstring>
 
 void ImageGenerator::initialize(const Reader& reader, const std::string& folder_path)
 {
     tiles_folder_path = folder_path;
-    tile_width = 0;
-    tile_height = 0;
-    channels = 0;
 
-    // Create mapping from tile ID to filename
-    for (int i = 0; i < reader.constraints.size(); i++)
+    // Decode every tile once, converted to the output channel count and padded with black
+    // to the common tile size, so rendering never touches the disk
+    std::vector<uint8_t> loaded;
+    Atlas::decode_tiles(folder_path, reader.constraints, tile_width, tile_height, channels, tile_storage, loaded);
+    size_t tile_bytes = static_cast<size_t>(tile_width) * tile_height * channels;
+    tile_cache.assign(reader.constraints.size(), nullptr);
+    for (size_t id = 0; id < tile_cache.size(); id++)
     {
-        tile_id_to_filename[i] = reader.constraints[i] + ".png";
+        if (loaded[id])
+            tile_cache[id] = tile_storage.data() + id * tile_bytes;
     }
+}
+
+void ImageGenerator::initialize(const Atlas& atlas)
+{
+    tiles_folder_path.clear();
+    std::vector<unsigned char>().swap(tile_storage);
+    tile_width = atlas.tile_width;
+    tile_height = atlas.tile_height;
+    channels = atlas.channels;
 
-    // Load first tile to get dimensions
-    if (!reader.constraints.empty())
+    // The atlas already holds decoded, padded tiles: point at them instead of copying
+    tile_cache.assign(atlas.constraints.size(), nullptr);
+    for (size_t id = 0; id < tile_cache.size(); id++)
     {
-        std::string first_tile_path = folder_path + "/" + tile_id_to_filename[0];
-        unsigned char* data = stbi_load(first_tile_path.c_str(), &tile_width, &tile_height, &channels, 0);
-        if (data)
-        {
-            stbi_image_free(data);
-            std::cout << "Tile dimensions: " << tile_width << "x" << tile_height << " with " << channels << " channels" << std::endl;
-        }
-        else
-        {
-            std::cerr << "Error: Could not load tile image: " << first_tile_path << std::endl;
-        }
+        if (atlas.loaded[id])
+            tile_cache[id] = atlas.tile_pixels(static_cast<int>(id));
     }
 }
 
+static bool ends_with(const std::string& text, const std::string& suffix)
+{
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
 void ImageGenerator::generate_image(const Matrix& matrix, const std::string& output_filename)
 {
     if (tile_width == 0 || tile_height == 0)
@@ -38,19 +50,144 @@ void ImageGenerator::generate_image(const Matrix& matrix, const std::string& out
         return;
     }
 
-    int output_width = matrix.columns * tile_width;
-    int output_height = matrix.rows * tile_height;
+    // stb's JPEG encoder needs the whole raster
+    if (output_filename.find(".jpg") != std::string::npos || output_filename.find(".jpeg") != std::string::npos)
+    {
+        generate_buffered_image(matrix, output_filename);
+        return;
+    }
+
+    std::string filename = output_filename;
+    if (!ends_with(filename, ".png") && !ends_with(filename, ".ppm") && !ends_with(filename, ".pgm") && !ends_with(filename, ".pam"))
+    {
+        filename += ".png"; // Default to PNG
+    }
+
+    // Tile rows are composed in parallel, one band per thread, and written out in order
+    ThreadPool pool(threads);
+    int group = std::max(1, std::min(pool.size(), matrix.rows));
+    bool success = begin_image(filename, matrix.rows, matrix.columns, group);
+    for (int first = 0; success && first < matrix.rows; first += group)
+    {
+        int count = std::min(group, matrix.rows - first);
+        pool.parallel_for(count, [&](size_t k) {
+            int row = first + static_cast<int>(k);
+            compose_band(&matrix.collapsed[matrix.index(row, 0)], row, band.data() + k * band_bytes);
+        });
+        success = raw_output ? raw_writer.write_rows(band.data(), count * tile_height)
+                             : png_writer.write_rows(band.data(), count * tile_height);
+    }
+    success = end_image() && success;
+
+    if (success)
+    {
+        std::cout << "Successfully generated image: " << filename << " (" << static_cast<size_t>(matrix.columns) * tile_width
+                  << "x" << static_cast<size_t>(matrix.rows) * tile_height << ")" << std::endl;
+    }
+    else
+    {
+        std::cerr << "Error: Failed to write image: " << filename << std::endl;
+    }
+}
+
+bool ImageGenerator::begin_image(const std::string& output_filename, int rows, int columns, int bands_in_flight)
+{
+    if (tile_width == 0 || tile_height == 0)
+    {
+        std::cerr << "Error: ImageGenerator not properly initialized!" << std::endl;
+        return false;
+    }
+
+    size_t output_width = static_cast<size_t>(columns) * tile_width;
+    size_t output_height = static_cast<size_t>(rows) * tile_height;
+    if (output_width > 0x7FFFFFFF || output_height > 0x7FFFFFFF)
+    {
+        std::cerr << "Error: Output image would be " << output_width << "x" << output_height
+                  << " pixels, beyond the 2^31 - 1 limit of the image formats" << std::endl;
+        return false;
+    }
+
+    image_columns = columns;
+    raw_output = ends_with(output_filename, ".ppm") || ends_with(output_filename, ".pgm") || ends_with(output_filename, ".pam");
+
+    // Only the bands in flight are held in memory, whatever the number of tile rows
+    band_bytes = output_width * tile_height * channels;
+    std::cout << "Creating output image: " << output_width << "x" << output_height
+              << " pixels (" << band_bytes / (1024 * 1024) << " MB per band)" << std::endl;
+    try {
+        band.assign(band_bytes * bands_in_flight, 0);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: Could not allocate memory for an image band: " << e.what() << std::endl;
+        return false;
+    }
+
+    if (raw_output)
+        return raw_writer.open(output_filename, static_cast<int>(output_width), static_cast<int>(output_height), channels);
+    return png_writer.open(output_filename, static_cast<int>(output_width), static_cast<int>(output_height), channels);
+}
+
+bool ImageGenerator::write_band(const int* ids, int row)
+{
+    compose_band(ids, row, band.data());
+    if (raw_output)
+        return raw_writer.write_rows(band.data(), tile_height);
+    return png_writer.write_rows(band.data(), tile_height);
+}
+
+bool ImageGenerator::end_image()
+{
+    bool success = raw_output ? raw_writer.close() : png_writer.close();
+    std::vector<unsigned char>().swap(band);
+    return success;
+}
+
+void ImageGenerator::set_threads(int threads)
+{
+    this->threads = threads;
+}
+
+void ImageGenerator::compose_band(const int* ids, int row, unsigned char* out)
+{
+    size_t band_stride = static_cast<size_t>(image_columns) * tile_width * channels;
+    size_t tile_stride = static_cast<size_t>(tile_width) * channels;
+
+    for (int col = 0; col < image_columns; col++)
+    {
+        // Tiles come from the cache decoded by initialize
+        int tile_id = ids[col];
+        if (tile_id < -1 || (tile_id >= 0 && static_cast<size_t>(tile_id) >= tile_cache.size()))
+        {
+            std::cerr << "Warning: Unknown tile ID " << tile_id << " at position (" << row << ", " << col << ")" << std::endl;
+            tile_id = -1;
+        }
+        const unsigned char* tile_data = tile_id == -1 ? nullptr : tile_cache[tile_id];
+        unsigned char* target = out + col * tile_stride;
+
+        // One contiguous copy per tile scanline; uncollapsed cells and missing tiles are black
+        for (int y = 0; y < tile_height; y++)
+        {
+            if (tile_data)
+                std::memcpy(target + y * band_stride, tile_data + y * tile_stride, tile_stride);
+            else
+                std::memset(target + y * band_stride, 0, tile_stride);
+        }
+    }
+}
+
+void ImageGenerator::generate_buffered_image(const Matrix& matrix, const std::string& output_filename)
+{
+    size_t output_width = static_cast<size_t>(matrix.columns) * tile_width;
+    size_t output_height = static_cast<size_t>(matrix.rows) * tile_height;
     
     // Check if the output image would be too large (more than 1GB)
-    long long total_pixels = (long long)output_width * output_height;
-    long long total_bytes = total_pixels * channels;
-    const long long max_bytes = 1LL * 1024 * 1024 * 1024; // 1GB limit
+    size_t total_bytes = output_width * output_height * channels;
+    const size_t max_bytes = 1ULL * 1024 * 1024 * 1024; // 1GB limit
     
     if (total_bytes > max_bytes)
     {
         std::cerr << "Error: Output image would be too large (" 
                   << total_bytes / (1024 * 1024) << " MB). "
-                  << "Consider reducing matrix size or tile dimensions." << std::endl;
+                  << "JPEG output is buffered, use .png or .ppm for streamed output." << std::endl;
         std::cerr << "Current dimensions: " << output_width << "x" << output_height 
                   << " pixels (" << matrix.rows << "x" << matrix.columns 
                   << " tiles of " << tile_width << "x" << tile_height << " pixels each)" << std::endl;
@@ -60,98 +197,24 @@ void ImageGenerator::generate_image(const Matrix& matrix, const std::string& out
     std::cout << "Creating output image: " << output_width << "x" << output_height 
               << " pixels (" << total_bytes / (1024 * 1024) << " MB)" << std::endl;
     
-    // Create output image buffer
+    // Create output image buffer from the same bands the streaming path renders
     std::vector<unsigned char> output_image;
     try {
-        output_image.resize(output_width * output_height * channels, 0);
+        output_image.resize(total_bytes, 0);
     } catch (const std::exception& e) {
         std::cerr << "Error: Could not allocate memory for output image: " << e.what() << std::endl;
         return;
     }
 
-    // Process each cell in the matrix
-    for (int row = 0; row < matrix.rows; row++)
-    {
-        for (int col = 0; col < matrix.columns; col++)
-        {
-            int tile_id = matrix.matrix[row][col].collapsed;
-            
-            if (tile_id == -1)
-            {
-                // Cell not collapsed, fill with black
-                for (int y = 0; y < tile_height; y++)
-                {
-                    for (int x = 0; x < tile_width; x++)
-                    {
-                        int output_y = row * tile_height + y;
-                        int output_x = col * tile_width + x;
-                        int output_index = (output_y * output_width + output_x) * channels;
-                        
-                        for (int c = 0; c < channels; c++)
-                        {
-                            output_image[output_index + c] = 0;
-                        }
-                    }
-                }
-                continue;
-            }
-
-            // Load the tile image
-            auto it = tile_id_to_filename.find(tile_id);
-            if (it == tile_id_to_filename.end())
-            {
-                std::cerr << "Warning: Unknown tile ID " << tile_id << " at position (" << row << ", " << col << ")" << std::endl;
-                continue;
-            }
-
-            std::string tile_path = tiles_folder_path + "/" + it->second;
-            int loaded_width, loaded_height, loaded_channels;
-            unsigned char* tile_data = stbi_load(tile_path.c_str(), &loaded_width, &loaded_height, &loaded_channels, channels);
-            
-            if (!tile_data)
-            {
-                std::cerr << "Warning: Could not load tile image: " << tile_path << std::endl;
-                continue;
-            }
-
-            // Copy tile data to output image
-            for (int y = 0; y < tile_height && y < loaded_height; y++)
-            {
-                for (int x = 0; x < tile_width && x < loaded_width; x++)
-                {
-                    int output_y = row * tile_height + y;
-                    int output_x = col * tile_width + x;
-                    int output_index = (output_y * output_width + output_x) * channels;
-                    int tile_index = (y * loaded_width + x) * channels;
-                    
-                    for (int c = 0; c < channels; c++)
-                    {
-                        output_image[output_index + c] = tile_data[tile_index + c];
-                    }
-                }
-            }
-
-            stbi_image_free(tile_data);
-        }
-    }
-
-    // Write the output image
-    int success = 0;
-    if (output_filename.find(".png") != std::string::npos)
-    {
-        success = stbi_write_png(output_filename.c_str(), output_width, output_height, channels, output_image.data(), output_width * channels);
-    }
-    else if (output_filename.find(".jpg") != std::string::npos || output_filename.find(".jpeg") != std::string::npos)
-    {
-        success = stbi_write_jpg(output_filename.c_str(), output_width, output_height, channels, output_image.data(), 90);
-    }
-    else
-    {
-        // Default to PNG
-        std::string png_filename = output_filename + ".png";
-        success = stbi_write_png(png_filename.c_str(), output_width, output_height, channels, output_image.data(), output_width * channels);
-    }
+    // Tile rows are disjoint slices of the raster, so they are composed in parallel in place
+    image_columns = matrix.columns;
+    band_bytes = output_width * tile_height * channels;
+    ThreadPool pool(threads);
+    pool.parallel_for(matrix.rows, [&](size_t row) {
+        compose_band(&matrix.collapsed[matrix.index(static_cast<int>(row), 0)], static_cast<int>(row), output_image.data() + row * band_bytes);
+    });
 
+    int success = stbi_write_jpg(output_filename.c_str(), static_cast<int>(output_width), static_cast<int>(output_height), channels, output_image.data(), 90);
     if (success)
     {
         std::cout << "Successfully generated image: " << output_filename << " (" << output_width << "x" << output_height << ")" << std::endl;
@@ -167,6 +230,10 @@ ImageGenerator::ImageGenerator()
     tile_width = 0;
     tile_height = 0;
     channels = 0;
+    raw_output = false;
+    image_columns = 0;
+    band_bytes = 0;
+    threads = 0;
 }
 
 ImageGenerator::~ImageGenerator()
@@ -3,24 +3,46 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <map>
 #include "Matrix.hpp"
 #include "Reader.hpp"
 #include "stb_image.h"
 #include "stb_image_write.h"
+#include "ImageWriter.hpp"
+#include "Atlas.hpp"
 
 class ImageGenerator
 {
 private:
-    std::map<int, std::string> tile_id_to_filename;
     std::string tiles_folder_path;
     int tile_width;
     int tile_height;
     int channels;
+    std::vector<unsigned char> tile_storage;      // Pixels decoded from a folder, tile after tile
+    std::vector<const unsigned char*> tile_cache; // Pixels by tile id (tile_width x tile_height x channels) in tile_storage or a mapped atlas; null when the tile failed to load
+
+    // Streaming output: one band (tile row, tile_height scanlines) is composed at a time
+    PngStreamWriter png_writer;
+    RawImageWriter raw_writer;
+    bool raw_output;
+    int image_columns;
+    size_t band_bytes;
+    std::vector<unsigned char> band; // Room for one band per band in flight
+    int threads; // Bands composed in parallel by generate_image, <= 0 for every hardware thread
+
+    void compose_band(const int* ids, int row, unsigned char* out);
+    void generate_buffered_image(const Matrix& matrix, const std::string& output_filename);
 
 public:
     void initialize(const Reader& reader, const std::string& folder_path);
+    void initialize(const Atlas& atlas); // Renders straight from the atlas, which must outlive the generator's use
     void generate_image(const Matrix& matrix, const std::string& output_filename);
+
+    // Incremental rendering for producers that emit tile rows in order (e.g. FP_STREAM).
+    // .ppm/.pgm/.pam files are written raw, anything else as PNG.
+    bool begin_image(const std::string& output_filename, int rows, int columns, int bands_in_flight = 1);
+    bool write_band(const int* ids, int row); // Tile ids of one tile row
+    bool end_image();
+    void set_threads(int threads);
     ImageGenerator();
     ~ImageGenerator();
 };
@@ -0,0 +1,419 @@
+#include "ImageWriter.hpp"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+static const size_t WINDOW_SIZE = 32768; // Deflate distance limit
+static const int HASH_BITS = 15;
+static const int MAX_CHAIN = 8;          // Candidates tried per position
+static const int MIN_MATCH = 3;
+static const int MAX_MATCH = 258;
+
+static const int length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const int length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const int distance_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const int distance_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static uint32_t crc32_update(uint32_t crc, const unsigned char* data, size_t size)
+{
+    static uint32_t table[256];
+    static bool ready = false;
+    if (!ready)
+    {
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        ready = true;
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// Deflate sends Huffman codes starting from the most significant bit
+static uint32_t reverse_bits(uint32_t code, int length)
+{
+    uint32_t reversed = 0;
+    for (int i = 0; i < length; i++)
+    {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    return reversed;
+}
+
+static void put_be32(unsigned char* out, uint32_t value)
+{
+    out[0] = static_cast<unsigned char>(value >> 24);
+    out[1] = static_cast<unsigned char>(value >> 16);
+    out[2] = static_cast<unsigned char>(value >> 8);
+    out[3] = static_cast<unsigned char>(value);
+}
+
+bool PngStreamWriter::open(const std::string& filename, int width, int height, int channels)
+{
+    static const unsigned char color_types[5] = { 0, 0, 4, 2, 6 }; // Gray, gray + alpha, RGB, RGBA
+    if (channels < 1 || channels > 4)
+    {
+        std::cerr << "Error: PNG output needs 1 to 4 channels, got " << channels << std::endl;
+        return false;
+    }
+
+    file = std::fopen(filename.c_str(), "wb");
+    if (!file)
+    {
+        std::cerr << "Error: Could not open " << filename << " for writing" << std::endl;
+        return false;
+    }
+
+    this->width = width;
+    this->channels = channels;
+    row_bytes = static_cast<size_t>(width) * channels;
+    previous.assign(row_bytes, 0);
+    filtered.assign(row_bytes + 1, 0);
+    candidate.assign(row_bytes + 1, 0);
+
+    window.clear();
+    window_base = 0;
+    head.assign(size_t(1) << HASH_BITS, 0);
+    chain.assign(WINDOW_SIZE, 0);
+    adler_a = 1;
+    adler_b = 0;
+    bit_buffer = 0;
+    bit_count = 0;
+    idat.clear();
+    failed = false;
+
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::fwrite(signature, 1, sizeof(signature), file);
+
+    unsigned char header[13];
+    put_be32(header, static_cast<uint32_t>(width));
+    put_be32(header + 4, static_cast<uint32_t>(height));
+    header[8] = 8; // Bit depth
+    header[9] = color_types[channels];
+    header[10] = 0; // Deflate
+    header[11] = 0; // Adaptive filtering
+    header[12] = 0; // No interlace
+    write_chunk("IHDR", header, sizeof(header));
+
+    // zlib header, then one fixed Huffman block that stays open until close
+    idat.push_back(0x78);
+    idat.push_back(0x01);
+    put_bits(0, 1); // BFINAL
+    put_bits(1, 2); // BTYPE = fixed codes
+    return true;
+}
+
+bool PngStreamWriter::write_rows(const unsigned char* pixels, int rows)
+{
+    if (!file)
+        return false;
+
+    for (int r = 0; r < rows; r++)
+    {
+        const unsigned char* row = pixels + static_cast<size_t>(r) * row_bytes;
+
+        // Try every filter and keep the one with the smallest sum of absolute residuals
+        long best_cost = -1;
+        for (int type = 0; type <= 4; type++)
+        {
+            if (type == 3)
+                continue; // Average rarely wins on tile art, skip it
+            candidate[0] = static_cast<unsigned char>(type);
+            long cost = 0;
+            for (size_t x = 0; x < row_bytes; x++)
+            {
+                int a = x >= static_cast<size_t>(channels) ? row[x - channels] : 0;
+                int b = previous[x];
+                int c = x >= static_cast<size_t>(channels) ? previous[x - channels] : 0;
+                int predicted = 0;
+                if (type == 1)
+                    predicted = a;
+                else if (type == 2)
+                    predicted = b;
+                else if (type == 4)
+                {
+                    int p = a + b - c;
+                    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+                    predicted = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+                }
+                unsigned char value = static_cast<unsigned char>(row[x] - predicted);
+                candidate[x + 1] = value;
+                cost += value < 128 ? value : 256 - value;
+            }
+            if (best_cost < 0 || cost < best_cost)
+            {
+                best_cost = cost;
+                filtered.swap(candidate);
+            }
+        }
+
+        deflate(filtered.data(), filtered.size());
+        std::memcpy(previous.data(), row, row_bytes);
+    }
+
+    flush_idat(false);
+    return !failed;
+}
+
+bool PngStreamWriter::close()
+{
+    if (!file)
+        return false;
+
+    // End the open block, then an empty final block
+    put_literal(256);
+    put_bits(1, 1);
+    put_bits(1, 2);
+    put_literal(256);
+    if (bit_count > 0)
+        put_bits(0, 8 - bit_count);
+
+    unsigned char adler[4];
+    put_be32(adler, (adler_b << 16) | adler_a);
+    idat.insert(idat.end(), adler, adler + 4);
+    flush_idat(true);
+    write_chunk("IEND", nullptr, 0);
+
+    bool ok = !failed && std::fclose(file) == 0;
+    file = nullptr;
+    return ok;
+}
+
+void PngStreamWriter::put_bits(uint32_t bits, int count)
+{
+    bit_buffer |= static_cast<uint64_t>(bits) << bit_count;
+    bit_count += count;
+    while (bit_count >= 8)
+    {
+        idat.push_back(static_cast<unsigned char>(bit_buffer));
+        bit_buffer >>= 8;
+        bit_count -= 8;
+    }
+}
+
+void PngStreamWriter::put_literal(int value)
+{
+    if (value <= 143)
+        put_bits(reverse_bits(0x30 + value, 8), 8);
+    else if (value <= 255)
+        put_bits(reverse_bits(0x190 + value - 144, 9), 9);
+    else if (value <= 279)
+        put_bits(reverse_bits(value - 256, 7), 7);
+    else
+        put_bits(reverse_bits(0xC0 + value - 280, 8), 8);
+}
+
+void PngStreamWriter::put_match(int length, int distance)
+{
+    int code = 28;
+    while (length_base[code] > length)
+        code--;
+    put_literal(257 + code);
+    put_bits(length - length_base[code], length_extra[code]);
+
+    code = 29;
+    while (distance_base[code] > distance)
+        code--;
+    put_bits(reverse_bits(code, 5), 5);
+    put_bits(distance - distance_base[code], distance_extra[code]);
+}
+
+void PngStreamWriter::deflate(const unsigned char* data, size_t size)
+{
+    // Adler-32 of the uncompressed stream, reduced every 5552 bytes as zlib does
+    for (size_t done = 0; done < size; )
+    {
+        size_t step = std::min<size_t>(size - done, 5552);
+        for (size_t i = 0; i < step; i++)
+        {
+            adler_a += data[done + i];
+            adler_b += adler_a;
+        }
+        adler_a %= 65521;
+        adler_b %= 65521;
+        done += step;
+    }
+
+    size_t pos = window.size();
+    window.insert(window.end(), data, data + size);
+    size_t end = window.size();
+    const unsigned char* w = window.data();
+    const uint32_t hash_mask = (1u << HASH_BITS) - 1;
+
+    auto hash_at = [&](size_t p) {
+        return ((static_cast<uint32_t>(w[p]) << 10) ^ (static_cast<uint32_t>(w[p + 1]) << 5) ^ w[p + 2]) & hash_mask;
+    };
+    // Positions are stored as (absolute position % 2^32) + 1; distances stay far below 2^32
+    auto insert = [&](size_t p) {
+        uint32_t h = hash_at(p);
+        uint32_t absolute = static_cast<uint32_t>(window_base + p);
+        chain[absolute % WINDOW_SIZE] = head[h];
+        head[h] = absolute + 1;
+    };
+
+    while (pos < end)
+    {
+        int best_length = 0;
+        size_t best_distance = 0;
+
+        if (end - pos >= static_cast<size_t>(MIN_MATCH))
+        {
+            uint32_t absolute = static_cast<uint32_t>(window_base + pos);
+            int limit = static_cast<int>(std::min<size_t>(MAX_MATCH, end - pos));
+            uint32_t next = head[hash_at(pos)];
+
+            for (int depth = 0; next != 0 && depth < MAX_CHAIN; depth++)
+            {
+                size_t distance = static_cast<uint32_t>(absolute - (next - 1));
+                if (distance == 0 || distance > WINDOW_SIZE || distance > pos)
+                    break;
+
+                const unsigned char* a = w + pos;
+                const unsigned char* b = a - distance;
+                int length = 0;
+                while (length < limit && a[length] == b[length])
+                    length++;
+                if (length > best_length)
+                {
+                    best_length = length;
+                    best_distance = distance;
+                    if (length == limit)
+                        break;
+                }
+                next = chain[(next - 1) % WINDOW_SIZE];
+            }
+            insert(pos);
+        }
+
+        if (best_length >= MIN_MATCH)
+        {
+            put_match(best_length, static_cast<int>(best_distance));
+            for (size_t p = pos + 1; p < pos + best_length && end - p >= static_cast<size_t>(MIN_MATCH); p++)
+                insert(p);
+            pos += best_length;
+        }
+        else
+        {
+            put_literal(w[pos]);
+            pos++;
+        }
+    }
+
+    // Keep only the last window of input, trimming in large steps
+    if (window.size() > 4 * WINDOW_SIZE)
+    {
+        size_t drop = window.size() - WINDOW_SIZE;
+        window.erase(window.begin(), window.begin() + drop);
+        window_base += drop;
+    }
+}
+
+void PngStreamWriter::flush_idat(bool force)
+{
+    if (idat.size() >= (size_t(1) << 16) || (force && !idat.empty()))
+    {
+        write_chunk("IDAT", idat.data(), idat.size());
+        idat.clear();
+    }
+}
+
+void PngStreamWriter::write_chunk(const char* type, const unsigned char* data, size_t size)
+{
+    unsigned char length[4];
+    put_be32(length, static_cast<uint32_t>(size));
+    uint32_t crc = crc32_update(0, reinterpret_cast<const unsigned char*>(type), 4);
+    if (size > 0)
+        crc = crc32_update(crc, data, size);
+    unsigned char crc_bytes[4];
+    put_be32(crc_bytes, crc);
+
+    bool ok = std::fwrite(length, 1, 4, file) == 4;
+    ok = ok && std::fwrite(type, 1, 4, file) == 4;
+    ok = ok && (size == 0 || std::fwrite(data, 1, size, file) == size);
+    ok = ok && std::fwrite(crc_bytes, 1, 4, file) == 4;
+    if (!ok && !failed)
+    {
+        std::cerr << "Error: Failed writing PNG data" << std::endl;
+        failed = true;
+    }
+}
+
+PngStreamWriter::PngStreamWriter()
+{
+    file = nullptr;
+    width = 0;
+    channels = 0;
+    row_bytes = 0;
+    window_base = 0;
+    adler_a = 1;
+    adler_b = 0;
+    bit_buffer = 0;
+    bit_count = 0;
+    failed = false;
+}
+
+PngStreamWriter::~PngStreamWriter()
+{
+    if (file)
+        std::fclose(file);
+}
+
+bool RawImageWriter::open(const std::string& filename, int width, int height, int channels)
+{
+    file = std::fopen(filename.c_str(), "wb");
+    if (!file)
+    {
+        std::cerr << "Error: Could not open " << filename << " for writing" << std::endl;
+        return false;
+    }
+    row_bytes = static_cast<size_t>(width) * channels;
+
+    if (channels == 1 || channels == 3)
+    {
+        std::fprintf(file, "P%c\n%d %d\n255\n", channels == 1 ? '5' : '6', width, height);
+    }
+    else
+    {
+        const char* tuple = channels == 2 ? "GRAYSCALE_ALPHA" : "RGB_ALPHA";
+        std::fprintf(file, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH %d\nMAXVAL 255\nTUPLTYPE %s\nENDHDR\n", width, height, channels, tuple);
+    }
+    return true;
+}
+
+bool RawImageWriter::write_rows(const unsigned char* pixels, int rows)
+{
+    if (!file)
+        return false;
+    size_t bytes = row_bytes * rows;
+    return std::fwrite(pixels, 1, bytes, file) == bytes;
+}
+
+bool RawImageWriter::close()
+{
+    if (!file)
+        return false;
+    bool ok = std::fclose(file) == 0;
+    file = nullptr;
+    return ok;
+}
+
+RawImageWriter::RawImageWriter()
+{
+    file = nullptr;
+    row_bytes = 0;
+}
+
+RawImageWriter::~RawImageWriter()
+{
+    if (file)
+        std::fclose(file);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Incremental PNG encoder: scanlines are filtered, deflated (fixed Huffman
+// codes with LZ77 over a 32 KB window) and written as they arrive, so memory
+// does not grow with the image height.
+class PngStreamWriter
+{
+private:
+    std::FILE* file;
+    int width;
+    int channels;
+    size_t row_bytes;
+
+    // PNG filtering
+    std::vector<unsigned char> previous;  // Last unfiltered scanline
+    std::vector<unsigned char> filtered;  // Filter byte + filtered scanline
+    std::vector<unsigned char> candidate; // Scratch for trying filters
+
+    // Deflate state
+    std::vector<unsigned char> window;    // Recent input, window[0] is at absolute position window_base
+    uint64_t window_base;
+    std::vector<uint32_t> head;           // Last position + 1 of each 3-byte hash, 0 when none
+    std::vector<uint32_t> chain;          // Previous position + 1 with the same hash, by position % 32K
+    uint32_t adler_a, adler_b;
+    uint64_t bit_buffer;
+    int bit_count;
+
+    // IDAT output
+    std::vector<unsigned char> idat;      // Compressed bytes not yet written as a chunk
+    bool failed;
+
+    void put_bits(uint32_t bits, int count);
+    void put_literal(int value);
+    void put_match(int length, int distance);
+    void deflate(const unsigned char* data, size_t size);
+    void flush_idat(bool force);
+    void write_chunk(const char* type, const unsigned char* data, size_t size);
+
+public:
+    bool open(const std::string& filename, int width, int height, int channels);
+    bool write_rows(const unsigned char* pixels, int rows); // rows scanlines of width * channels bytes
+    bool close();
+    PngStreamWriter();
+    ~PngStreamWriter();
+};
+
+// Uncompressed Netpbm writer: PGM for 1 channel, PPM for 3, PAM otherwise.
+class RawImageWriter
+{
+private:
+    std::FILE* file;
+    size_t row_bytes;
+
+public:
+    bool open(const std::string& filename, int width, int height, int channels);
+    bool write_rows(const unsigned char* pixels, int rows);
+    bool close();
+    RawImageWriter();
+    ~RawImageWriter();
+};
@@ -4,9 +4,30 @@ void Matrix::initialize_matrix(int rows, int columns, Cell c)
 {
     this->rows = rows;
     this->columns = columns;
-    matrix.assign(rows, std::vector<Cell>(columns, c));
-    //std::vector<std::vector<Cell>> mat(rows, std::vector<Cell>(columns, c));
-    //matrix = mat;
+    this->words = c.domain.words();
+
+    size_t count = static_cast<size_t>(rows) * columns;
+    collapsed.assign(count, c.collapsed);
+    domain_sizes.assign(count, static_cast<uint16_t>(c.domain.size()));
+    domains.resize(count * words);
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        std::copy(c.domain.bits.begin(), c.domain.bits.end(), domain(idx));
+    }
+}
+
+void Matrix::initialize_ids(int rows, int columns)
+{
+    this->rows = rows;
+    this->columns = columns;
+    this->words = 0;
+
+    size_t count = static_cast<size_t>(rows) * columns;
+    collapsed.assign(count, -1);
+
+    // No domains at all, release whatever a previous grid left behind
+    std::vector<uint64_t>().swap(domains);
+    std::vector<uint16_t>().swap(domain_sizes);
 }
 
 void Matrix::print_possibilities(void)
@@ -16,7 +37,7 @@ void Matrix::print_possibilities(void)
     {
         for(int j = 0; j < columns; j++)
         {
-            matrix[i][j].print_domain_size();
+            std::cout << domain_sizes[index(i, j)] << " ";
         }
         std::cout << std::endl;
     }
@@ -30,24 +51,62 @@ void Matrix::print_ids(void)
     {
         for(int j = 0; j < columns; j++)
         {
-            std::cout << std::setw(2) << std::setfill('0') << matrix[i][j].collapsed << " ";
+            std::cout << std::setw(2) << std::setfill('0') << collapsed[index(i, j)] << " ";
         }
         std::cout << std::endl;
     }
     std::cout << "===============================" << std::endl;
 }
 
+Domain Matrix::get_domain(size_t idx) const
+{
+    Domain d;
+    d.bits.assign(domain(idx), domain(idx) + words);
+    return d;
+}
+
+Cell Matrix::get_cell(int i, int j) const
+{
+    Cell c;
+    c.collapsed = collapsed[index(i, j)];
+    c.domain = get_domain(index(i, j));
+    return c;
+}
+
+void Matrix::set_cell(int i, int j, const Cell& c)
+{
+    size_t idx = index(i, j);
+    collapsed[idx] = c.collapsed;
+    std::copy(c.domain.bits.begin(), c.domain.bits.end(), domain(idx));
+    domain_sizes[idx] = static_cast<uint16_t>(c.domain.size());
+}
+
+void Matrix::copy_cell(const Matrix& src, int src_i, int src_j, int i, int j)
+{
+    size_t src_idx = src.index(src_i, src_j);
+    size_t idx = index(i, j);
+    collapsed[idx] = src.collapsed[src_idx];
+    std::copy(src.domain(src_idx), src.domain(src_idx) + words, domain(idx));
+    domain_sizes[idx] = src.domain_sizes[src_idx];
+}
+
 Matrix::Matrix()
 {
     rows = 0;
     columns = 0;
+    words = 0;
+    trail = nullptr;
 }
 
 Matrix::Matrix(const Matrix& other)
 {
     rows = other.rows;
     columns = other.columns;
-    matrix = other.matrix;
+    words = other.words;
+    collapsed = other.collapsed;
+    domains = other.domains;
+    domain_sizes = other.domain_sizes;
+    trail = nullptr;
 }
 
 Matrix& Matrix::operator=(const Matrix& other)
@@ -55,7 +114,10 @@ Matrix& Matrix::operator=(const Matrix& other)
     if (this != &other) {
         rows = other.rows;
         columns = other.columns;
-        matrix = other.matrix;
+        words = other.words;
+        collapsed = other.collapsed;
+        domains = other.domains;
+        domain_sizes = other.domain_sizes;
     }
     return *this;
 }
@@ -69,15 +131,10 @@ size_t Matrix::get_memory_usage() const
     size_t size = 0;
     size += sizeof(*this); // Base object size
     
-    // Calculate memory for the 2D vector structure
-    size += sizeof(std::vector<Cell>) * matrix.capacity(); // Outer vector capacity
-    
-    for (const auto& row : matrix) {
-        size += sizeof(Cell) * row.capacity(); // Inner vector capacity
-        for (const auto& cell : row) {
-            size += cell.get_memory_usage() - sizeof(Cell); // Cell content minus base size
-        }
-    }
+    // One contiguous allocation per array
+    size += collapsed.capacity() * sizeof(int);
+    size += domains.capacity() * sizeof(uint64_t);
+    size += domain_sizes.capacity() * sizeof(uint16_t);
     
     return size;
-}
\ No newline at end of file
+}
@@ -2,22 +2,139 @@
 
 #include <iomanip>
 #include "Cell.hpp"
+#include "Trail.hpp"
 
+// Outcome of a propagation step. When a domain is wiped out, row/col name
+// the first cell left without any tile.
+struct PropagationResult {
+    bool contradiction;
+    int row;
+    int col;
+};
+
+// Row-major grid stored as separate contiguous arrays (structure of arrays).
+// Cell (i, j) lives at linear offset index(i, j) in every array; its domain
+// occupies words consecutive entries of domains starting at index * words.
+// When trail is set, every change made through restrict_domain/assign_single
+// is logged so rollback can undo it.
 class Matrix
 {
 private:
     
 public:
-    std::vector<std::vector<Cell>> matrix;
     int rows;
     int columns;
+    int words;                          // Domain words per cell
+    std::vector<int> collapsed;         // Collapsed tile id, -1 when not collapsed
+    std::vector<uint64_t> domains;      // Domain bitsets, words per cell
+    std::vector<uint16_t> domain_sizes; // Cached popcount of each domain
+    Trail* trail;                       // Undo log, nullptr when not backtracking (never copied)
 
     void initialize_matrix(int rows, int columns, Cell c);
+    void initialize_ids(int rows, int columns); // Tile ids only, for engines that keep no domains
     void print_possibilities(void);
     void print_ids(void);
+    Domain get_domain(size_t idx) const;
+    Cell get_cell(int i, int j) const;
+    void set_cell(int i, int j, const Cell& c);
+    void copy_cell(const Matrix& src, int src_i, int src_j, int i, int j);
     size_t get_memory_usage() const;
     Matrix();
     Matrix(const Matrix& other); // Copy constructor
     Matrix& operator=(const Matrix& other); // Assignment operator
     ~Matrix();
-};
\ No newline at end of file
+
+    size_t index(int i, int j) const { return static_cast<size_t>(i) * columns + j; }
+    size_t cells() const { return collapsed.size(); }
+    uint64_t* domain(size_t idx) { return domains.data() + idx * words; }
+    const uint64_t* domain(size_t idx) const { return domains.data() + idx * words; }
+
+    // domain &= mask, keeping the cached size in sync; returns true when the domain changed
+    bool restrict_domain(size_t idx, const uint64_t* mask)
+    {
+        if (trail)
+        {
+            uint64_t* d = domain(idx);
+            bool changed = false;
+            for (int w = 0; w < words; w++)
+            {
+                uint64_t next = d[w] & mask[w];
+                if (next != d[w])
+                {
+                    trail->record(idx, w, d[w]);
+                    d[w] = next;
+                    changed = true;
+                }
+            }
+            if (!changed)
+                return false;
+        }
+        else if (!bits_and(domain(idx), mask, words))
+        {
+            return false;
+        }
+        domain_sizes[idx] = static_cast<uint16_t>(bits_count(domain(idx), words));
+        return true;
+    }
+
+    // Clears one tile from the domain; returns true when it was present
+    bool remove_tile(size_t idx, int tile)
+    {
+        uint64_t* word = domain(idx) + (tile >> 6);
+        uint64_t bit = uint64_t(1) << (tile & 63);
+        if (!(*word & bit))
+            return false;
+        if (trail)
+            trail->record(idx, tile >> 6, *word);
+        *word &= ~bit;
+        domain_sizes[idx]--;
+        return true;
+    }
+
+    // Collapses the cell to a single tile
+    void assign_single(size_t idx, int tile)
+    {
+        uint64_t* d = domain(idx);
+        if (trail)
+        {
+            trail->record(idx, -1, static_cast<uint64_t>(collapsed[idx]));
+            for (int w = 0; w < words; w++)
+            {
+                uint64_t next = (w == (tile >> 6)) ? uint64_t(1) << (tile & 63) : 0;
+                if (next != d[w])
+                    trail->record(idx, w, d[w]);
+            }
+        }
+        std::fill(d, d + words, 0);
+        d[tile >> 6] = uint64_t(1) << (tile & 63);
+        domain_sizes[idx] = 1;
+        collapsed[idx] = tile;
+    }
+
+    // Undoes trail entries down to mark, newest first. For each entry calls
+    // on_cell(idx, word, restored_bits), where restored_bits are the tiles of
+    // that domain word brought back (0 for collapsed id entries, word == -1).
+    template <typename F>
+    void rollback(size_t mark, F on_cell)
+    {
+        while (trail->entries.size() > mark)
+        {
+            TrailEntry entry = trail->entries.back();
+            trail->entries.pop_back();
+
+            uint64_t restored = 0;
+            if (entry.word < 0)
+            {
+                collapsed[entry.cell] = static_cast<int>(entry.old);
+            }
+            else
+            {
+                uint64_t& word = domain(entry.cell)[entry.word];
+                restored = entry.old & ~word;
+                word = entry.old;
+                domain_sizes[entry.cell] = static_cast<uint16_t>(bits_count(domain(entry.cell), words));
+            }
+            on_cell(entry.cell, entry.word, restored);
+        }
+    }
+};
@@ -0,0 +1,136 @@
+#include "MemoryTracker.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+static std::atomic<uint64_t> allocated_bytes(0);
+static std::atomic<uint64_t> allocation_count(0);
+static std::atomic<uint64_t> live_bytes(0);
+static std::atomic<uint64_t> peak_live_bytes(0);
+
+// Every block carries its size in front so delete can update the live bytes without
+// relying on sized delete. 16 bytes keep the alignment malloc guarantees
+static const size_t HEADER_BYTES = 16;
+
+// GCC cannot tell that the replaced operator new hands out malloc memory
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static void* tracked_allocate(std::size_t size)
+{
+    unsigned char* block = static_cast<unsigned char*>(std::malloc(size + HEADER_BYTES));
+    if (!block)
+        throw std::bad_alloc();
+    std::memcpy(block, &size, sizeof(size));
+
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    uint64_t live = live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    uint64_t peak = peak_live_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !peak_live_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    {
+    }
+    return block + HEADER_BYTES;
+}
+
+static void tracked_free(void* p) noexcept
+{
+    if (!p)
+        return;
+    unsigned char* block = static_cast<unsigned char*>(p) - HEADER_BYTES;
+    std::size_t size;
+    std::memcpy(&size, block, sizeof(size));
+    live_bytes.fetch_sub(size, std::memory_order_relaxed);
+    std::free(block);
+}
+
+void* operator new(std::size_t size) { return tracked_allocate(size); }
+void* operator new[](std::size_t size) { return tracked_allocate(size); }
+void operator delete(void* p) noexcept { tracked_free(p); }
+void operator delete[](void* p) noexcept { tracked_free(p); }
+void operator delete(void* p, std::size_t) noexcept { tracked_free(p); }
+void operator delete[](void* p, std::size_t) noexcept { tracked_free(p); }
+
+MemorySnapshot MemoryTracker::snapshot()
+{
+    MemorySnapshot snapshot;
+    snapshot.allocated_bytes = allocated_bytes.load(std::memory_order_relaxed);
+    snapshot.allocations = allocation_count.load(std::memory_order_relaxed);
+    snapshot.live_bytes = live_bytes.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+size_t MemoryTracker::peak_rss()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return 0;
+#else
+#if defined(__linux__)
+    // VmHWM follows reset_peak_rss, ru_maxrss does not
+    if (std::FILE* status = std::fopen("/proc/self/status", "r"))
+    {
+        char line[256];
+        unsigned long long kb = 0;
+        bool found = false;
+        while (!found && std::fgets(line, sizeof(line), status))
+            found = std::sscanf(line, "VmHWM: %llu kB", &kb) == 1;
+        std::fclose(status);
+        if (found)
+            return static_cast<size_t>(kb) * 1024;
+    }
+#endif
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#if defined(__APPLE__)
+    return static_cast<size_t>(usage.ru_maxrss);        // Bytes
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024; // Kilobytes
+#endif
+#endif
+}
+
+bool MemoryTracker::reset_peak_rss()
+{
+#if defined(__linux__)
+    std::FILE* clear_refs = std::fopen("/proc/self/clear_refs", "w");
+    if (!clear_refs)
+        return false;
+    bool success = std::fputs("5", clear_refs) >= 0;
+    return std::fclose(clear_refs) == 0 && success;
+#else
+    return false;
+#endif
+}
+
+void MemoryTracker::begin()
+{
+    start = snapshot();
+    peak_live_bytes.store(start.live_bytes, std::memory_order_relaxed);
+}
+
+PhaseMemory MemoryTracker::end() const
+{
+    MemorySnapshot now = snapshot();
+    uint64_t peak = peak_live_bytes.load(std::memory_order_relaxed);
+    PhaseMemory phase;
+    phase.allocated_bytes = now.allocated_bytes - start.allocated_bytes;
+    phase.allocations = now.allocations - start.allocations;
+    phase.peak_bytes = peak > start.live_bytes ? peak - start.live_bytes : 0;
+    phase.retained_bytes = static_cast<int64_t>(now.live_bytes) - static_cast<int64_t>(start.live_bytes);
+    return phase;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Heap counters fed by the global operator new/delete replaced in MemoryTracker.cpp.
+// Every program that links MemoryTracker.cpp counts all of its allocations: bytes
+// requested, number of calls, bytes currently live and the peak of live bytes since
+// the last begin_phase. Counters are process wide (relaxed atomics), so phases of
+// runs executing concurrently are not separable.
+struct MemorySnapshot
+{
+    uint64_t allocated_bytes; // Requested by operator new since start
+    uint64_t allocations;     // Calls of operator new since start
+    uint64_t live_bytes;      // Allocated and not yet deleted
+};
+
+// What happened on the heap between begin() and end()
+struct PhaseMemory
+{
+    uint64_t allocated_bytes;
+    uint64_t allocations;
+    uint64_t peak_bytes;      // Highest live bytes above the level at begin()
+    int64_t retained_bytes;   // Live bytes at end() minus live bytes at begin()
+};
+
+class MemoryTracker
+{
+private:
+    MemorySnapshot start;
+
+public:
+    static MemorySnapshot snapshot();
+    static size_t peak_rss();       // Process peak resident set size in bytes, 0 when unknown
+    static bool reset_peak_rss();   // Restarts the peak from the current RSS (Linux only)
+
+    void begin();                   // Also restarts the process-wide live peak
+    PhaseMemory end() const;
+};
@@ -1,16 +1,19 @@
 #include "NWFC.hpp"
 #include "WFC.hpp"
+#include "ThreadPool.hpp"
 #include <algorithm>
 #include <iostream>
 
-void NWFC::initialize_nwfc(int rows, int columns, int subgrid_size, Cell c, unsigned int seed)
+void NWFC::initialize_nwfc(int rows, int columns, int subgrid_size, Cell c, const Tileset& tileset, unsigned int seed)
 {
+    this->tileset = &tileset;
     this->subgrid_size = subgrid_size;
     this->original_domain = c.domain; // Store the original domain
     this->rows = (rows * (subgrid_size - 1) + 1);
     this->columns = (columns * (subgrid_size - 1) + 1);
     this->total_backtracks = 0;
     this->total_backtrack_memory = 0;
+    this->seed = seed;
     rng.seed(seed);
     matrix.initialize_matrix(this->rows, this->columns, c);
 
@@ -27,64 +30,122 @@ void NWFC::run(bool enable_backtracking)
 
     for (int subgrid_row = 0; subgrid_row < subgrids_rows; ++subgrid_row) {
         for (int subgrid_col = 0; subgrid_col < subgrids_cols; ++subgrid_col) {
-            int start_row = subgrid_row * (subgrid_size - 1);
-            int start_col = subgrid_col * (subgrid_size - 1);
-
-            // Determine if we need a phantom border
-            bool add_bottom = enable_backtracking && (subgrid_row < subgrids_rows - 1);
-            bool add_right  = enable_backtracking && (subgrid_col < subgrids_cols - 1);
-
-            int wfc_rows = subgrid_size + (add_bottom ? 1 : 0);
-            int wfc_cols = subgrid_size + (add_right  ? 1 : 0);
-
-            // Initialize the WFC solver on the extended window
-            WFC subgrid_wfc;
-            Cell base_cell; base_cell.domain = original_domain;
-            subgrid_wfc.initialize_wfc(wfc_rows, wfc_cols, base_cell, rng());
-
-            // Copy the current global state into the top-left of subgrid_wfc
-            for (int i = 0; i < subgrid_size; ++i) {
-                for (int j = 0; j < subgrid_size; ++j) {
-                    int gi = start_row + i;
-                    int gj = start_col + j;
-                    subgrid_wfc.matrix.matrix[i][j] = matrix.matrix[gi][gj];
-                }
-            }
-            // (The extra bottom/right row/col remain at base_cell.domain)
-
-            // If not the very first subgrid, do AC-3 propagation on its top/left border
-            if (subgrid_row > 0 || subgrid_col > 0) {
-                for (int i = 0; i < wfc_rows; ++i) {
-                    for (int j = 0; j < wfc_cols; ++j) {
-                        if (subgrid_wfc.matrix.matrix[i][j].collapsed != -1) {
-                            bool is_border =
-                                (subgrid_row > 0 && i == 0) ||     // top edge
-                                (subgrid_col > 0 && j == 0);      // left edge
-                            if (is_border) subgrid_wfc.propagate(i, j);
-                        }
-                    }
-                }
-            }
+            int backtracks = 0;
+            size_t backtrack_memory = 0;
+            solve_subgrid(subgrid_row, subgrid_col, enable_backtracking, rng(), backtracks, backtrack_memory);
+            total_backtracks += backtracks;
+            total_backtrack_memory += backtrack_memory;
+        }
+    }
+}
 
-            // Collapse!
-            if (enable_backtracking) {
-                subgrid_wfc.MRV(true);
-                total_backtracks      += subgrid_wfc.get_backtrack_count();
-                total_backtrack_memory += subgrid_wfc.get_backtrack_stack_memory_usage();
-            } else {
-                subgrid_wfc.MRV();
-            }
+void NWFC::run_parallel(bool enable_backtracking, int threads)
+{
+    int subgrids_rows = (rows - 1) / (subgrid_size - 1);
+    int subgrids_cols = (columns - 1) / (subgrid_size - 1);
+
+    // Reset stats
+    total_backtracks = total_backtrack_memory = 0;
+
+    // Subgrid (r,c) shares its top row with (r-1,c), its left column with (r,c-1) and its
+    // top-right corner with (r-1,c+1). Every one of those has a smaller 2r + c, and two
+    // subgrids with the same 2r + c never overlap, so each wavefront runs in parallel.
+    std::vector<int> backtracks(static_cast<size_t>(subgrids_rows) * subgrids_cols, 0);
+    std::vector<size_t> backtrack_memory(backtracks.size(), 0);
+    ThreadPool pool(threads);
+
+    for (int wave = 0; wave <= 2 * (subgrids_rows - 1) + subgrids_cols - 1; ++wave) {
+        int first_row = std::max(0, (wave - subgrids_cols + 2) / 2);
+        int last_row = std::min(subgrids_rows - 1, wave / 2);
+        if (first_row > last_row) continue;
+
+        pool.parallel_for(last_row - first_row + 1, [&](size_t k) {
+            int subgrid_row = first_row + static_cast<int>(k);
+            int subgrid_col = wave - 2 * subgrid_row;
+            size_t slot = static_cast<size_t>(subgrid_row) * subgrids_cols + subgrid_col;
+            // Seeded by position, not by solve order, so any thread count gives the same grid
+            solve_subgrid(subgrid_row, subgrid_col, enable_backtracking, subgrid_seed(subgrid_row, subgrid_col),
+                          backtracks[slot], backtrack_memory[slot]);
+        });
+    }
+
+    for (size_t slot = 0; slot < backtracks.size(); slot++) {
+        total_backtracks += backtracks[slot];
+        total_backtrack_memory += backtrack_memory[slot];
+    }
+}
 
-            // Copy **only** the original subgrid back into the global matrix
-            for (int i = 0; i < subgrid_size; ++i) {
-                for (int j = 0; j < subgrid_size; ++j) {
-                    int gi = start_row + i;
-                    int gj = start_col + j;
-                    matrix.matrix[gi][gj] = subgrid_wfc.matrix.matrix[i][j];
+unsigned int NWFC::subgrid_seed(int subgrid_row, int subgrid_col) const
+{
+    // splitmix64 finalizer over the run seed and the subgrid coordinates
+    uint64_t z = seed + ((static_cast<uint64_t>(subgrid_row) << 32 | static_cast<uint32_t>(subgrid_col)) + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return static_cast<unsigned int>((z ^ (z >> 31)) >> 32);
+}
+
+void NWFC::solve_subgrid(int subgrid_row, int subgrid_col, bool enable_backtracking, unsigned int wfc_seed,
+                         int& backtracks, size_t& backtrack_memory)
+{
+    int subgrids_rows = (rows - 1) / (subgrid_size - 1);
+    int subgrids_cols = (columns - 1) / (subgrid_size - 1);
+    int start_row = subgrid_row * (subgrid_size - 1);
+    int start_col = subgrid_col * (subgrid_size - 1);
+
+    // Determine if we need a phantom border
+    bool add_bottom = enable_backtracking && (subgrid_row < subgrids_rows - 1);
+    bool add_right  = enable_backtracking && (subgrid_col < subgrids_cols - 1);
+
+    int wfc_rows = subgrid_size + (add_bottom ? 1 : 0);
+    int wfc_cols = subgrid_size + (add_right  ? 1 : 0);
+
+    // Initialize the WFC solver on the extended window
+    WFC subgrid_wfc;
+    Cell base_cell; base_cell.domain = original_domain;
+    subgrid_wfc.initialize_wfc(wfc_rows, wfc_cols, base_cell, *tileset, wfc_seed);
+    subgrid_wfc.set_propagation(propagation);
+
+    // Copy the current global state into the top-left of subgrid_wfc
+    for (int i = 0; i < subgrid_size; ++i) {
+        for (int j = 0; j < subgrid_size; ++j) {
+            int gi = start_row + i;
+            int gj = start_col + j;
+            subgrid_wfc.matrix.copy_cell(matrix, gi, gj, i, j);
+        }
+    }
+    // (The extra bottom/right row/col remain at base_cell.domain)
+
+    // If not the very first subgrid, do AC-3 propagation on its top/left border
+    if (subgrid_row > 0 || subgrid_col > 0) {
+        for (int i = 0; i < wfc_rows; ++i) {
+            for (int j = 0; j < wfc_cols; ++j) {
+                if (subgrid_wfc.matrix.collapsed[subgrid_wfc.matrix.index(i, j)] != -1) {
+                    bool is_border =
+                        (subgrid_row > 0 && i == 0) ||     // top edge
+                        (subgrid_col > 0 && j == 0);      // left edge
+                    if (is_border) subgrid_wfc.propagate(i, j);
                 }
             }
         }
     }
+
+    // Collapse!
+    if (enable_backtracking) {
+        subgrid_wfc.MRV(true);
+        backtracks       = subgrid_wfc.get_backtrack_count();
+        backtrack_memory = subgrid_wfc.get_backtrack_stack_memory_usage();
+    } else {
+        subgrid_wfc.MRV();
+    }
+
+    // Copy **only** the original subgrid back into the global matrix
+    for (int i = 0; i < subgrid_size; ++i) {
+        for (int j = 0; j < subgrid_size; ++j) {
+            int gi = start_row + i;
+            int gj = start_col + j;
+            matrix.copy_cell(subgrid_wfc.matrix, i, j, gi, gj);
+        }
+    }
 }
 
 size_t NWFC::get_matrix_memory_usage() const
@@ -106,10 +167,7 @@ size_t NWFC::get_memory_usage() const
     size += sizeof(rng);
     
     // Original domain vector
-    size += original_domain.capacity() * sizeof(Tile);
-    for (const auto& tile : original_domain) {
-        size += tile.get_memory_usage() - sizeof(Tile); // Subtract base Tile size to avoid double counting
-    }
+    size += original_domain.get_memory_usage() - sizeof(Domain);
     
     return size;
 }
@@ -124,8 +182,20 @@ size_t NWFC::get_total_backtrack_stack_memory_usage() const
     return total_backtrack_memory;
 }
 
+bool NWFC::set_propagation(std::string mode)
+{
+    // Checked once here so the subgrid engines never fall back to another mode
+    if (tileset ? !WFC::supports_propagation(mode, *tileset) : mode != "AC3" && mode != "AC4" && mode != "LABEL")
+        return false;
+    propagation = mode;
+    return true;
+}
+
 NWFC::NWFC(/* args */)
 {
+    tileset = nullptr;
+    seed = 0;
+    propagation = "AC3";
 }
 
 NWFC::~NWFC()
@@ -2,25 +2,36 @@
 
 #include <random>
 #include <vector>
+#include <string>
 #include "Matrix.hpp"
 #include "Tile.hpp"
+#include "Tileset.hpp"
 
 class NWFC
 {
 private:
     int total_backtracks;
     size_t total_backtrack_memory;
+    std::string propagation; // Passed on to every subgrid WFC
+    unsigned int seed; // Base of the per-subgrid seeds of run_parallel
+
+    void solve_subgrid(int subgrid_row, int subgrid_col, bool enable_backtracking, unsigned int wfc_seed,
+                       int& backtracks, size_t& backtrack_memory);
+    unsigned int subgrid_seed(int subgrid_row, int subgrid_col) const;
     
 public:
     int rows;
     int columns;
     int subgrid_size;
-    std::vector<Tile> original_domain;
+    Domain original_domain;
     Matrix matrix;
+    const Tileset* tileset;
     std::mt19937 rng;
 
-    void initialize_nwfc(int rows, int columns, int subgrid_size, Cell c, unsigned int seed);
+    void initialize_nwfc(int rows, int columns, int subgrid_size, Cell c, const Tileset& tileset, unsigned int seed);
     void run(bool enable_backtracking = false);
+    void run_parallel(bool enable_backtracking, int threads); // Subgrids by wavefront, threads <= 0 uses every core
+    bool set_propagation(std::string mode);
     size_t get_memory_usage() const;
     size_t get_matrix_memory_usage() const;
     int get_total_backtrack_count() const;
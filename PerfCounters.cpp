@@ -0,0 +1,132 @@
+#include "PerfCounters.hpp"
+
+#if defined(__linux__)
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Same order as the PerfSample fields
+static const uint64_t EVENT_CONFIGS[] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+static int open_event(uint64_t config)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+#endif
+
+PerfSample& PerfSample::operator+=(const PerfSample& other)
+{
+    cycles += other.cycles;
+    instructions += other.instructions;
+    cache_misses += other.cache_misses;
+    branch_misses += other.branch_misses;
+    return *this;
+}
+
+bool PerfCounters::open()
+{
+    close();
+#if defined(__linux__)
+    int opened = 0;
+    for (int e = 0; e < EVENTS; e++)
+    {
+        fds[e] = open_event(EVENT_CONFIGS[e]);
+        opened += fds[e] >= 0;
+    }
+    return opened > 0;
+#else
+    return false;
+#endif
+}
+
+void PerfCounters::close()
+{
+    for (int e = 0; e < EVENTS; e++)
+    {
+#if defined(__linux__)
+        if (fds[e] >= 0)
+            ::close(fds[e]);
+#endif
+        fds[e] = -1;
+    }
+}
+
+bool PerfCounters::is_open() const
+{
+    for (int e = 0; e < EVENTS; e++)
+    {
+        if (fds[e] >= 0)
+            return true;
+    }
+    return false;
+}
+
+void PerfCounters::start()
+{
+#if defined(__linux__)
+    for (int e = 0; e < EVENTS; e++)
+    {
+        if (fds[e] >= 0)
+        {
+            ioctl(fds[e], PERF_EVENT_IOC_RESET, 0);
+            ioctl(fds[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+PerfSample PerfCounters::stop()
+{
+    uint64_t values[EVENTS] = {};
+#if defined(__linux__)
+    for (int e = 0; e < EVENTS; e++)
+    {
+        if (fds[e] >= 0)
+            ioctl(fds[e], PERF_EVENT_IOC_DISABLE, 0);
+    }
+    for (int e = 0; e < EVENTS; e++)
+    {
+        // value, time enabled, time running; scale up when the counter was multiplexed
+        uint64_t data[3];
+        if (fds[e] < 0 || read(fds[e], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0)
+            continue;
+        values[e] = data[2] < data[1] ? static_cast<uint64_t>(static_cast<double>(data[0]) * data[1] / data[2]) : data[0];
+    }
+#endif
+    PerfSample sample;
+    sample.cycles = values[0];
+    sample.instructions = values[1];
+    sample.cache_misses = values[2];
+    sample.branch_misses = values[3];
+    return sample;
+}
+
+PerfCounters::PerfCounters()
+{
+    for (int e = 0; e < EVENTS; e++)
+    {
+        fds[e] = -1;
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    close();
+}
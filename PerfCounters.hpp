@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts of one measured section. Counters the CPU or kernel refuse stay at 0
+struct PerfSample
+{
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t cache_misses;    // Last level cache misses
+    uint64_t branch_misses;
+
+    double ipc() const { return cycles ? static_cast<double>(instructions) / cycles : 0.0; }
+    PerfSample& operator+=(const PerfSample& other);
+};
+
+// Hardware performance counters of the calling thread and of the threads it starts while
+// counting (the pools of the parallel algorithms), user space only, through Linux
+// perf_event_open. Counts are scaled when the kernel multiplexes the counters.
+// Elsewhere, or when perf_event_paranoid or the machine (VMs without a PMU) forbid it,
+// open() fails (silently, callers decide whether to warn) and the sections read as zeros.
+class PerfCounters
+{
+private:
+    static const int EVENTS = 4;
+    int fds[EVENTS];
+
+public:
+    bool open();
+    void close();
+    bool is_open() const;
+    void start();
+    PerfSample stop();
+
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+};
@@ -1,4 +1,5 @@
 #include "Reader.hpp"
+#include <algorithm>
 
 void Reader::read_files(std::string filepath)
 {
@@ -9,6 +10,9 @@ void Reader::read_files(std::string filepath)
 
         constraints.push_back(constraints_str);
     }
+
+    // Tile ids follow the file names, not the directory order of the filesystem
+    std::sort(constraints.begin(), constraints.end());
 }
 
 void Reader::print_constraints(void)
@@ -20,15 +24,36 @@ void Reader::print_constraints(void)
     }
 }
 
+uint8_t Reader::intern_label(char label)
+{
+    for (size_t code = 0; code < labels.size(); code++)
+    {
+        if (labels[code] == label)
+            return static_cast<uint8_t>(code);
+    }
+
+    labels.push_back(label);
+    return static_cast<uint8_t>(labels.size() - 1);
+}
+
 std::vector<Tile> Reader::generate_domain(void)
 {
     std::vector<Tile> domain;
 
-    // Initialize domain with every possible tile
-    for (int i = 0; i < constraints.size(); i++)
+    if (constraints.size() > UINT16_MAX)
+    {
+        std::cerr << "Error: Tileset has " << constraints.size() << " tiles, only the first " << UINT16_MAX << " are used" << std::endl;
+    }
+    size_t tile_count = std::min<size_t>(constraints.size(), UINT16_MAX);
+    domain.reserve(tile_count);
+
+    // Initialize domain with every possible tile, interning the edge labels (NSEW) once
+    labels.clear();
+    for (size_t i = 0; i < tile_count; i++)
     {
+        const std::string& c = constraints[i];
         Tile t;
-        t.set_tile_constraints(constraints[i], std::to_string(i));
+        t.set_tile_constraints(static_cast<uint16_t>(i), intern_label(c[0]), intern_label(c[1]), intern_label(c[2]), intern_label(c[3]));
         domain.push_back(t);
     }
 
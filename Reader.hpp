@@ -4,6 +4,7 @@
 #include <vector>
 #include <string>
 #include <filesystem>
+#include <cstdint>
 #include "Tile.hpp"
 
 class Reader
@@ -12,10 +13,12 @@ private:
     
 public:
     std::vector<std::string> constraints;
+    std::vector<char> labels; // Edge label for each interned code
 
     void read_files(std::string filepath);
     void print_constraints(void);
+    uint8_t intern_label(char label);
     std::vector<Tile> generate_domain(void);
     Reader(/* args */);
     ~Reader();
-};
\ No newline at end of file
+};
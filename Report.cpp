@@ -0,0 +1,556 @@
+#include "Report.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <map>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// Per-run metrics that get a min/median/p95/max/mean in the summary
+struct Metric
+{
+    const char* name;
+    double (*value)(const RunResult& result);
+};
+
+static double cells_per_second(const RunResult& result)
+{
+    return result.run_ms > 0.0 ? result.cells / (result.run_ms / 1000.0) : 0.0;
+}
+
+static double ns_per_cell(const RunResult& result)
+{
+    return result.cells > 0 ? result.run_ms * 1e6 / result.cells : 0.0;
+}
+
+static const Metric METRICS[] = {
+    {"init_ms", [](const RunResult& r) { return r.init_ms; }},
+    {"run_ms", [](const RunResult& r) { return r.run_ms; }},
+    {"total_ms", [](const RunResult& r) { return r.total_ms; }},
+    {"cells_per_second", cells_per_second},
+    {"ns_per_cell", ns_per_cell},
+    {"backtracks", [](const RunResult& r) { return static_cast<double>(r.backtracks); }},
+    {"memory_bytes", [](const RunResult& r) { return static_cast<double>(r.memory); }},
+    {"peak_heap_bytes", [](const RunResult& r) { return static_cast<double>(r.peak_heap); }},
+    {"allocated_bytes", [](const RunResult& r) { return static_cast<double>(r.init_heap.allocated_bytes + r.run_heap.allocated_bytes); }},
+    {"allocations", [](const RunResult& r) { return static_cast<double>(r.init_heap.allocations + r.run_heap.allocations); }},
+    {"peak_rss_bytes", [](const RunResult& r) { return static_cast<double>(r.peak_rss); }},
+    {"cycles", [](const RunResult& r) { return static_cast<double>(r.run_perf.cycles); }},
+    {"instructions", [](const RunResult& r) { return static_cast<double>(r.run_perf.instructions); }},
+    {"ipc", [](const RunResult& r) { return r.run_perf.ipc(); }},
+    {"cache_misses_per_cell", [](const RunResult& r) { return r.cells ? static_cast<double>(r.run_perf.cache_misses) / r.cells : 0.0; }},
+    {"branch_misses_per_cell", [](const RunResult& r) { return r.cells ? static_cast<double>(r.run_perf.branch_misses) / r.cells : 0.0; }},
+};
+
+Stats summarize(std::vector<double> values)
+{
+    Stats stats = {};
+    if (values.empty())
+        return stats;
+
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    stats.min = values.front();
+    stats.max = values.back();
+    stats.median = n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.0;
+    size_t rank = static_cast<size_t>(std::ceil(0.95 * n));
+    stats.p95 = values[std::max<size_t>(rank, 1) - 1];
+    double sum = 0.0;
+    for (double v : values)
+        sum += v;
+    stats.mean = sum / n;
+    return stats;
+}
+
+// Linear interpolation between the closest ranks of sorted values
+static double quantile(const std::vector<double>& sorted, double q)
+{
+    double position = q * (sorted.size() - 1);
+    size_t below = static_cast<size_t>(position);
+    if (below + 1 >= sorted.size())
+        return sorted.back();
+    return sorted[below] + (position - below) * (sorted[below + 1] - sorted[below]);
+}
+
+std::vector<double> drop_outliers(std::vector<double> values)
+{
+    if (values.size() < 4)
+        return values;
+    std::vector<double> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    double q1 = quantile(sorted, 0.25);
+    double q3 = quantile(sorted, 0.75);
+    double low = q1 - 1.5 * (q3 - q1);
+    double high = q3 + 1.5 * (q3 - q1);
+    values.erase(std::remove_if(values.begin(), values.end(), [&](double v) { return v < low || v > high; }), values.end());
+    return values;
+}
+
+// Continued fraction of the incomplete beta function (modified Lentz)
+static double beta_fraction(double a, double b, double x)
+{
+    const double tiny = 1e-300;
+    double c = 1.0;
+    double d = 1.0 - (a + b) * x / (a + 1.0);
+    d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+    double h = d;
+    for (int m = 1; m <= 300; m++)
+    {
+        double m2 = 2.0 * m;
+        double numerator = m * (b - m) * x / ((a + m2 - 1.0) * (a + m2));
+        d = 1.0 + numerator * d;
+        c = 1.0 + numerator / c;
+        d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+        c = std::fabs(c) < tiny ? tiny : c;
+        h *= d * c;
+
+        numerator = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0));
+        d = 1.0 + numerator * d;
+        c = 1.0 + numerator / c;
+        d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+        c = std::fabs(c) < tiny ? tiny : c;
+        double step = d * c;
+        h *= step;
+        if (std::fabs(step - 1.0) < 1e-13)
+            break;
+    }
+    return h;
+}
+
+// Regularized incomplete beta function I_x(a, b)
+static double incomplete_beta(double a, double b, double x)
+{
+    if (x <= 0.0)
+        return 0.0;
+    if (x >= 1.0)
+        return 1.0;
+    double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1.0 - x));
+    if (x < (a + 1.0) / (a + b + 2.0))
+        return front * beta_fraction(a, b, x) / a;
+    return 1.0 - front * beta_fraction(b, a, 1.0 - x) / b;
+}
+
+double student_t_cdf(double t, double df)
+{
+    double tail = 0.5 * incomplete_beta(df / 2.0, 0.5, df / (df + t * t));
+    return t > 0.0 ? 1.0 - tail : tail;
+}
+
+// t such that P(-t < T < t) = confidence, by bisection on the CDF
+static double student_t_critical(double confidence, double df)
+{
+    double target = 0.5 + confidence / 2.0;
+    double low = 0.0, high = 1000.0;
+    for (int i = 0; i < 100; i++)
+    {
+        double mid = (low + high) / 2.0;
+        if (student_t_cdf(mid, df) < target)
+            low = mid;
+        else
+            high = mid;
+    }
+    return (low + high) / 2.0;
+}
+
+static void mean_variance(const std::vector<double>& values, double& mean, double& variance)
+{
+    mean = 0.0;
+    for (double v : values)
+        mean += v;
+    mean /= values.size();
+    variance = 0.0;
+    for (double v : values)
+        variance += (v - mean) * (v - mean);
+    variance = values.size() > 1 ? variance / (values.size() - 1) : 0.0;
+}
+
+Interval confidence_interval(const std::vector<double>& values, double confidence)
+{
+    Interval interval = {};
+    std::vector<double> kept = drop_outliers(values);
+    interval.samples = static_cast<int>(kept.size());
+    interval.outliers = static_cast<int>(values.size() - kept.size());
+    if (kept.empty())
+        return interval;
+
+    double variance;
+    mean_variance(kept, interval.mean, variance);
+    interval.stddev = std::sqrt(variance);
+    double half = kept.size() > 1 ? student_t_critical(confidence, kept.size() - 1.0) * interval.stddev / std::sqrt(static_cast<double>(kept.size())) : 0.0;
+    interval.low = interval.mean - half;
+    interval.high = interval.mean + half;
+    return interval;
+}
+
+static std::string json_string(const std::string& text)
+{
+    std::string out = "\"";
+    for (char ch : text)
+    {
+        if (ch == '"' || ch == '\\')
+        {
+            out += '\\';
+            out += ch;
+        }
+        else if (static_cast<unsigned char>(ch) < 0x20)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", ch);
+            out += escaped;
+        }
+        else
+        {
+            out += ch;
+        }
+    }
+    return out + "\"";
+}
+
+static std::string csv_field(const std::string& text)
+{
+    if (text.find_first_of(",\"\n") == std::string::npos)
+        return text;
+    std::string out = "\"";
+    for (char ch : text)
+        out += ch == '"' ? std::string("\"\"") : std::string(1, ch);
+    return out + "\"";
+}
+
+static std::string hex64(uint64_t value)
+{
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0') << value;
+    return oss.str();
+}
+
+static std::string json_common(const ReportInfo& info)
+{
+    std::ostringstream common;
+    common << "\"algorithm\": " << json_string(info.algorithm)
+           << ", \"tileset\": " << json_string(info.tileset)
+           << ", \"rows\": " << info.rows << ", \"columns\": " << info.columns
+           << ", \"subgrid_size\": " << info.subgrid_size
+           << ", \"propagation\": " << json_string(info.propagation)
+           << ", \"threads\": " << info.threads;
+    return common.str();
+}
+
+static void write_json_summary(std::ostream& out, const ReportGroup& group, const char* indent)
+{
+    const ReportInfo& info = group.info;
+    out << "{" << json_common(info) << ", \"run_count\": " << group.results.size()
+        << ", \"warmup\": " << info.warmup << ", \"pinned\": " << (info.pinned ? "true" : "false")
+        << ", \"read_ms\": " << info.read_ms << ", \"wall_ms\": " << info.wall_ms;
+    if (group.scaling > 0.0)
+        out << ", \"ns_per_cell_scaling\": " << group.scaling;
+    for (const Metric& metric : METRICS)
+    {
+        std::vector<double> values;
+        for (const RunResult& result : group.results)
+            values.push_back(metric.value(result));
+        Stats stats = summarize(values);
+        Interval ci = confidence_interval(values);
+        out << ",\n" << indent << "\"" << metric.name << "\": {\"min\": " << stats.min << ", \"median\": " << stats.median
+            << ", \"p95\": " << stats.p95 << ", \"max\": " << stats.max << ", \"mean\": " << stats.mean
+            << ", \"ci95_low\": " << ci.low << ", \"ci95_high\": " << ci.high << ", \"outliers\": " << ci.outliers << "}";
+    }
+    out << "}";
+}
+
+static void write_json(std::ostream& out, const std::vector<ReportGroup>& groups, bool sweep)
+{
+    out << "{\n  \"runs\": [";
+    bool first = true;
+    for (const ReportGroup& group : groups)
+    {
+        std::string common = json_common(group.info);
+        for (const RunResult& result : group.results)
+        {
+            out << (first ? "\n" : ",\n") << "    {" << common << ", \"run\": " << result.run << ", \"seed\": " << result.seed
+                << ", \"cells\": " << result.cells;
+            for (const Metric& metric : METRICS)
+                out << ", \"" << metric.name << "\": " << metric.value(result);
+            out << ", \"fingerprint\": \"" << hex64(result.fingerprint) << "\"}";
+            first = false;
+        }
+    }
+    out << "\n  ],\n";
+
+    if (sweep)
+    {
+        out << "  \"sweep\": [";
+        for (size_t g = 0; g < groups.size(); g++)
+        {
+            out << (g ? ",\n    " : "\n    ");
+            write_json_summary(out, groups[g], "      ");
+        }
+        out << "\n  ]\n}\n";
+    }
+    else
+    {
+        out << "  \"summary\": ";
+        write_json_summary(out, groups.front(), "    ");
+        out << "\n}\n";
+    }
+}
+
+static void write_csv(std::ostream& out, const std::vector<ReportGroup>& groups)
+{
+    out << "record,algorithm,tileset,rows,columns,subgrid_size,propagation,threads,read_ms,run,seed,cells";
+    for (const Metric& metric : METRICS)
+        out << "," << metric.name;
+    out << ",fingerprint\n";
+
+    for (const ReportGroup& group : groups)
+    {
+        const ReportInfo& info = group.info;
+        const std::vector<RunResult>& results = group.results;
+        std::ostringstream common;
+        common << std::setprecision(10) << csv_field(info.algorithm) << "," << csv_field(info.tileset) << "," << info.rows << ","
+               << info.columns << "," << info.subgrid_size << "," << info.propagation << "," << info.threads << "," << info.read_ms;
+
+        for (const RunResult& result : results)
+        {
+            out << "run," << common.str() << "," << result.run << "," << result.seed << "," << result.cells;
+            for (const Metric& metric : METRICS)
+                out << "," << metric.value(result);
+            out << "," << hex64(result.fingerprint) << "\n";
+        }
+
+        // Summary rows leave the per-run columns empty
+        std::vector<Stats> stats;
+        std::vector<Interval> intervals;
+        for (const Metric& metric : METRICS)
+        {
+            std::vector<double> values;
+            for (const RunResult& result : results)
+                values.push_back(metric.value(result));
+            stats.push_back(summarize(values));
+            intervals.push_back(confidence_interval(values));
+        }
+        const char* names[] = {"min", "median", "p95", "max", "mean", "ci95_low", "ci95_high"};
+        for (int s = 0; s < 7; s++)
+        {
+            out << names[s] << "," << common.str() << ",,," << (results.empty() ? 0 : results[0].cells);
+            for (size_t m = 0; m < stats.size(); m++)
+            {
+                const Stats& st = stats[m];
+                double values[] = {st.min, st.median, st.p95, st.max, st.mean, intervals[m].low, intervals[m].high};
+                out << "," << values[s];
+            }
+            out << ",\n";
+        }
+    }
+}
+
+static bool write_groups(const std::string& path, const std::string& format, const std::vector<ReportGroup>& groups, bool sweep)
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cerr << "Error: Could not open " << path << " for writing" << std::endl;
+        return false;
+    }
+    out << std::setprecision(10);
+
+    if (format == "json")
+        write_json(out, groups, sweep);
+    else if (format == "csv")
+        write_csv(out, groups);
+    else
+    {
+        std::cerr << "Error: Unknown report format '" << format << "'" << std::endl;
+        return false;
+    }
+
+    out.flush();
+    if (!out)
+    {
+        std::cerr << "Error: Failed to write report: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool write_report(const std::string& path, const std::string& format, const ReportInfo& info, const std::vector<RunResult>& results)
+{
+    ReportGroup group;
+    group.info = info;
+    group.results = results;
+    return write_groups(path, format, std::vector<ReportGroup>(1, group), false);
+}
+
+bool write_sweep_report(const std::string& path, const std::string& format, const std::vector<ReportGroup>& groups)
+{
+    return write_groups(path, format, groups, true);
+}
+
+// Reads the flat {"key": value, ...} object starting at text[pos]; values are kept as text
+static bool parse_flat_object(const std::string& text, size_t& pos, std::map<std::string, std::string>& fields)
+{
+    auto skip_space = [&]() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+            pos++;
+    };
+    auto parse_string = [&](std::string& value) {
+        if (pos >= text.size() || text[pos] != '"')
+            return false;
+        value.clear();
+        for (pos++; pos < text.size() && text[pos] != '"'; pos++)
+        {
+            if (text[pos] == '\\' && pos + 1 < text.size())
+                pos++;
+            value += text[pos];
+        }
+        pos++;
+        return pos <= text.size();
+    };
+
+    skip_space();
+    if (pos >= text.size() || text[pos] != '{')
+        return false;
+    pos++;
+    while (true)
+    {
+        skip_space();
+        if (pos < text.size() && text[pos] == '}')
+        {
+            pos++;
+            return true;
+        }
+        std::string key, value;
+        if (!parse_string(key))
+            return false;
+        skip_space();
+        if (pos >= text.size() || text[pos] != ':')
+            return false;
+        pos++;
+        skip_space();
+        if (pos < text.size() && text[pos] == '"')
+        {
+            if (!parse_string(value))
+                return false;
+        }
+        else
+        {
+            size_t end = text.find_first_of(",}", pos);
+            if (end == std::string::npos || text[pos] == '{' || text[pos] == '[')
+                return false;
+            value = text.substr(pos, end - pos);
+            while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back())))
+                value.pop_back();
+            pos = end;
+        }
+        fields[key] = value;
+        skip_space();
+        if (pos < text.size() && text[pos] == ',')
+            pos++;
+    }
+}
+
+bool load_baseline(const std::string& path, std::vector<BaselineRun>& runs)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        std::cerr << "Error: Could not open baseline: " << path << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string text = buffer.str();
+
+    size_t pos = text.find("\"runs\"");
+    pos = pos == std::string::npos ? pos : text.find('[', pos);
+    if (pos == std::string::npos)
+    {
+        std::cerr << "Error: " << path << " is not a JSON report (no \"runs\" array)" << std::endl;
+        return false;
+    }
+    pos++;
+
+    while (true)
+    {
+        while (pos < text.size() && (std::isspace(static_cast<unsigned char>(text[pos])) || text[pos] == ','))
+            pos++;
+        if (pos >= text.size() || text[pos] == ']')
+            break;
+
+        std::map<std::string, std::string> fields;
+        if (!parse_flat_object(text, pos, fields) || !fields.count("run_ms"))
+        {
+            std::cerr << "Error: Malformed run record in baseline: " << path << std::endl;
+            return false;
+        }
+        BaselineRun run;
+        run.algorithm = fields["algorithm"];
+        run.tileset = fields["tileset"];
+        run.propagation = fields["propagation"];
+        run.rows = std::atoi(fields["rows"].c_str());
+        run.columns = std::atoi(fields["columns"].c_str());
+        run.subgrid_size = std::atoi(fields["subgrid_size"].c_str());
+        run.run_ms = std::atof(fields["run_ms"].c_str());
+        runs.push_back(run);
+    }
+    return true;
+}
+
+Comparison compare_with_baseline(const std::vector<BaselineRun>& baseline, const ReportInfo& info,
+                                 const std::vector<RunResult>& results, double alpha, double min_change)
+{
+    Comparison comparison = {};
+    std::vector<double> before, after;
+    for (const BaselineRun& run : baseline)
+    {
+        if (run.algorithm == info.algorithm && run.tileset == info.tileset && run.propagation == info.propagation &&
+            run.rows == info.rows && run.columns == info.columns && run.subgrid_size == info.subgrid_size)
+            before.push_back(run.run_ms);
+    }
+    for (const RunResult& result : results)
+        after.push_back(result.run_ms);
+    before = drop_outliers(before);
+    after = drop_outliers(after);
+
+    comparison.baseline_samples = static_cast<int>(before.size());
+    comparison.current_samples = static_cast<int>(after.size());
+    comparison.p_value = 1.0;
+    if (before.empty() || after.empty())
+        return comparison;
+
+    double before_variance, after_variance;
+    mean_variance(before, comparison.baseline_mean, before_variance);
+    mean_variance(after, comparison.current_mean, after_variance);
+    comparison.change = comparison.baseline_mean > 0.0 ? comparison.current_mean / comparison.baseline_mean - 1.0 : 0.0;
+    comparison.change_low = comparison.change_high = comparison.change;
+    if (before.size() < 2 || after.size() < 2)
+        return comparison;
+
+    // Welch's t-test with the Welch-Satterthwaite degrees of freedom
+    double before_term = before_variance / before.size();
+    double after_term = after_variance / after.size();
+    double se2 = before_term + after_term;
+    if (se2 <= 0.0)
+    {
+        comparison.p_value = comparison.current_mean == comparison.baseline_mean ? 1.0 : 0.0;
+    }
+    else
+    {
+        double t = (comparison.current_mean - comparison.baseline_mean) / std::sqrt(se2);
+        double df = se2 * se2 / (before_term * before_term / (before.size() - 1) + after_term * after_term / (after.size() - 1));
+        comparison.p_value = 2.0 * (1.0 - student_t_cdf(std::fabs(t), df));
+
+        // Interval of the difference of means, relative to the baseline mean
+        if (comparison.baseline_mean > 0.0)
+        {
+            double half = student_t_critical(1.0 - alpha, df) * std::sqrt(se2) / comparison.baseline_mean;
+            comparison.change_low = comparison.change - half;
+            comparison.change_high = comparison.change + half;
+        }
+    }
+    comparison.significant = comparison.p_value < alpha && std::fabs(comparison.change) >= min_change;
+    return comparison;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Runner.hpp"
+
+// Parameters shared by every run of a benchmark, repeated in each record
+struct ReportInfo
+{
+    std::string algorithm;
+    std::string tileset;
+    std::string propagation;
+    int rows;
+    int columns;
+    int subgrid_size;
+    int threads;
+    double read_ms;   // Reading the tileset, done once for all runs
+    double wall_ms;   // Wall-clock time of all runs together
+    int warmup;       // Unmeasured runs done before the measured ones
+    bool pinned;      // Runs were pinned to CPUs
+};
+
+// Distribution of one metric over the runs
+struct Stats
+{
+    double min;
+    double median;
+    double p95;       // Nearest rank
+    double max;
+    double mean;
+};
+
+// Mean with a two-sided Student-t confidence interval, after dropping Tukey outliers
+// (values more than 1.5 IQR outside the quartiles)
+struct Interval
+{
+    double mean;
+    double low;
+    double high;
+    double stddev;
+    int samples;      // Values kept
+    int outliers;     // Values dropped
+};
+
+Stats summarize(std::vector<double> values);
+std::vector<double> drop_outliers(std::vector<double> values);
+Interval confidence_interval(const std::vector<double>& values, double confidence = 0.95);
+double student_t_cdf(double t, double df);
+
+// Run time of one run of a JSON report written by --format=json
+struct BaselineRun
+{
+    std::string algorithm;
+    std::string tileset;
+    std::string propagation;
+    int rows;
+    int columns;
+    int subgrid_size;
+    double run_ms;
+};
+
+// Welch's t-test of the run times of the current runs against the baseline runs with the
+// same algorithm, tileset, grid, subgrid and propagation (outliers dropped on both sides).
+// A change only counts when it is both unlikely to be noise (p < alpha) and large enough to
+// matter (at least min_change), so sub-percent jitter never flags with many runs
+struct Comparison
+{
+    int baseline_samples; // 0 when the baseline has no matching runs
+    int current_samples;
+    double baseline_mean;
+    double current_mean;
+    double change;        // Relative change of the mean run time, 0.05 = 5% slower
+    double change_low;    // 1 - alpha confidence interval of change (Welch)
+    double change_high;
+    double p_value;       // Two-sided
+    bool significant;     // p_value < alpha and |change| >= min_change
+};
+
+bool load_baseline(const std::string& path, std::vector<BaselineRun>& runs);
+Comparison compare_with_baseline(const std::vector<BaselineRun>& baseline, const ReportInfo& info,
+                                 const std::vector<RunResult>& results, double alpha, double min_change);
+
+// The runs of one configuration of a sweep
+struct ReportGroup
+{
+    ReportInfo info;
+    std::vector<RunResult> results;
+    double scaling = 0.0; // Median ns/cell over that of the smallest grid of the same configuration, 0 when unknown
+};
+
+// Writes one record per run plus a summary (min/median/p95/max/mean and 95% confidence
+// interval of each metric).
+// format is "json" (one document with "runs" and "summary") or "csv" (one row per run,
+// then one row per statistic, told apart by the "record" column)
+bool write_report(const std::string& path, const std::string& format, const ReportInfo& info, const std::vector<RunResult>& results);
+
+// Same records for every group of a sweep; JSON has a "sweep" array of summaries (with
+// ns_per_cell_scaling) instead of "summary", CSV repeats the summary rows per group
+bool write_sweep_report(const std::string& path, const std::string& format, const std::vector<ReportGroup>& groups);
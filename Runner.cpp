@@ -0,0 +1,249 @@
+#include "Runner.hpp"
+#include "FastPropagation.hpp"
+#include "WFC.hpp"
+#include "NWFC.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+bool is_backtracking(const std::string& algorithm)
+{
+    return algorithm == "FP_BACKTRACK" || algorithm == "FP_DIAGONAL_BACKTRACK" ||
+           algorithm == "WFC_BACKTRACK" || algorithm == "WFC_DIAGONAL_BACKTRACK" ||
+           algorithm == "NWFC_BACKTRACK" || algorithm == "NWFC_PARALLEL_BACKTRACK";
+}
+
+uint64_t fingerprint_ids(uint64_t hash, const int* ids, size_t count)
+{
+    // FNV-1a over the little-endian bytes of each id
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t id = static_cast<uint32_t>(ids[i]);
+        for (int b = 0; b < 4; b++)
+        {
+            hash ^= (id >> (8 * b)) & 0xFF;
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
+
+static void record_grid(RunResult& result, const Matrix& matrix)
+{
+    result.cells = matrix.cells();
+    result.fingerprint = fingerprint_ids(FINGERPRINT_BASIS, matrix.collapsed.data(), matrix.collapsed.size());
+}
+
+RunResult run_once(const RunConfig& config, int run, unsigned int seed, const RunOutput& output)
+{
+    using Clock = std::chrono::high_resolution_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    const std::string& algorithm = config.algorithm;
+    const Cell& c = *config.cell;
+    const Tileset& tileset = *config.tileset;
+    int grid_size = config.grid_size;
+
+    RunResult result = {};
+    result.run = run;
+    result.seed = seed;
+    result.known = true;
+    result.backtracking = is_backtracking(algorithm);
+    result.fingerprint = FINGERPRINT_BASIS;
+
+    PerfCounters counters;
+    if (config.perf)
+        result.perf = counters.open();
+
+    MemoryTracker heap;
+    heap.begin();
+    counters.start();
+    auto t_start = Clock::now();
+    Clock::time_point init_end, run_start, run_end;
+
+    if (algorithm.rfind("FP", 0) == 0)
+    {
+        FastPropagation fp;
+        if (algorithm == "FP_TABLE" || algorithm == "FP_DIAGONAL_PARALLEL")
+            fp.initialize_fp_table(grid_size, grid_size, tileset, seed);
+        else if (algorithm == "FP_STREAM")
+            fp.initialize_fp_stream(config.stream_rows, grid_size, tileset, seed);
+        else
+            fp.initialize_fp(grid_size, grid_size, c, tileset, seed);
+        fp.set_threads(config.threads);
+        init_end = Clock::now();
+        result.init_heap = heap.end();
+        result.init_perf = counters.stop();
+
+        // The stream is rendered band by band while rows are produced
+        bool render = output.image && algorithm == "FP_STREAM" &&
+                      output.image->begin_image(output.image_file, config.stream_rows, grid_size);
+
+        heap.begin();
+        counters.start();
+        run_start = Clock::now();
+        if (algorithm == "FP") fp.run("FP");
+        else if (algorithm == "FP_TABLE") fp.run("Table");
+        else if (algorithm == "FP_DIAGONAL_PARALLEL") fp.run("DiagonalParallel");
+        else if (algorithm == "FP_DIAGONAL") fp.run("Diagonal");
+        else if (algorithm == "FP_BACKTRACK") fp.FP(true); // Enable backtracking
+        else if (algorithm == "FP_DIAGONAL_BACKTRACK") fp.Diag(true); // Enable backtracking for diagonal
+        else if (algorithm == "FP_STREAM")
+        {
+            fp.Stream([&](int row, const int* ids) {
+                for (int j = 0; j < grid_size; j++)
+                    result.uncollapsed += ids[j] == -1;
+                result.fingerprint = fingerprint_ids(result.fingerprint, ids, grid_size);
+                if (output.ids)
+                    std::fwrite(ids, sizeof(int), grid_size, output.ids);
+                if (render)
+                    render = output.image->write_band(ids, row);
+            });
+        }
+        else result.known = false;
+        run_end = Clock::now();
+        result.run_heap = heap.end();
+        result.run_perf = counters.stop();
+
+        if (result.backtracking)
+        {
+            result.backtracks = fp.get_backtrack_count();
+            result.backtrack_memory = fp.get_backtrack_stack_memory_usage(); // Use current stack size instead of cumulative cost
+        }
+        result.memory = fp.get_memory_usage();
+        if (algorithm == "FP_STREAM")
+            result.cells = static_cast<size_t>(config.stream_rows) * grid_size;
+        else
+            record_grid(result, fp.matrix);
+
+        counters.start();
+        if (output.image && algorithm == "FP_STREAM")
+        {
+            if (!output.image->end_image())
+                std::cerr << "Error: Failed to write image: " << output.image_file << std::endl;
+        }
+        else if (output.image && result.known)
+        {
+            output.image->generate_image(fp.matrix, output.image_file);
+        }
+        result.render_perf = counters.stop();
+    }
+    else if (algorithm.rfind("WFC", 0) == 0)
+    {
+        WFC wfc;
+        wfc.initialize_wfc(grid_size, grid_size, c, tileset, seed);
+        wfc.set_propagation(config.propagation);
+        init_end = Clock::now();
+        result.init_heap = heap.end();
+        result.init_perf = counters.stop();
+
+        heap.begin();
+        counters.start();
+        run_start = Clock::now();
+        if (algorithm == "WFC") wfc.run("MRV");
+        else if (algorithm == "WFC_BACKTRACK") wfc.MRV(true); // Enable backtracking
+        else if (algorithm == "WFC_DIAGONAL") wfc.run("Diagonal");
+        else if (algorithm == "WFC_DIAGONAL_BACKTRACK") wfc.Diag(true); // Enable backtracking for diagonal
+        else result.known = false;
+        run_end = Clock::now();
+        result.run_heap = heap.end();
+        result.run_perf = counters.stop();
+
+        if (result.backtracking)
+        {
+            result.backtracks = wfc.get_backtrack_count();
+            result.backtrack_memory = wfc.get_backtrack_stack_memory_usage();
+        }
+        result.memory = wfc.get_memory_usage();
+        record_grid(result, wfc.matrix);
+
+        counters.start();
+        if (output.image && result.known)
+            output.image->generate_image(wfc.matrix, output.image_file);
+        result.render_perf = counters.stop();
+    }
+    else if (algorithm.rfind("NWFC", 0) == 0)
+    {
+        NWFC nwfc;
+        nwfc.initialize_nwfc(grid_size, grid_size, config.subgrid_size, c, tileset, seed);
+        nwfc.set_propagation(config.propagation);
+        init_end = Clock::now();
+        result.init_heap = heap.end();
+        result.init_perf = counters.stop();
+
+        heap.begin();
+        counters.start();
+        run_start = Clock::now();
+        if (algorithm == "NWFC") nwfc.run();
+        else if (algorithm == "NWFC_BACKTRACK") nwfc.run(true); // Enable backtracking
+        else if (algorithm == "NWFC_PARALLEL") nwfc.run_parallel(false, config.threads);
+        else if (algorithm == "NWFC_PARALLEL_BACKTRACK") nwfc.run_parallel(true, config.threads);
+        else result.known = false;
+        run_end = Clock::now();
+        result.run_heap = heap.end();
+        result.run_perf = counters.stop();
+
+        if (result.backtracking)
+        {
+            result.backtracks = nwfc.get_total_backtrack_count();
+            result.backtrack_memory = nwfc.get_total_backtrack_stack_memory_usage();
+        }
+        result.memory = nwfc.get_memory_usage();
+        record_grid(result, nwfc.matrix);
+
+        counters.start();
+        if (output.image && result.known)
+            output.image->generate_image(nwfc.matrix, output.image_file);
+        result.render_perf = counters.stop();
+    }
+    else
+    {
+        result.known = false;
+        init_end = run_start = run_end = t_start;
+    }
+    result.peak_heap = std::max<uint64_t>(result.init_heap.peak_bytes,
+                                          std::max<int64_t>(result.init_heap.retained_bytes, 0) + result.run_heap.peak_bytes);
+
+    result.init_ms = Milliseconds(init_end - t_start).count();
+    result.run_ms = Milliseconds(run_end - run_start).count();
+    result.total_ms = Milliseconds(Clock::now() - t_start).count();
+    result.peak_rss = MemoryTracker::peak_rss();
+    return result;
+}
+
+// Without a reset VmHWM only grows, and every run would report the peak of the runs before it
+static void reset_peak_rss_or_warn()
+{
+    static bool warned = false;
+    if (!MemoryTracker::reset_peak_rss() && !warned)
+    {
+        warned = true;
+        std::cerr << "Warning: Could not reset the peak RSS, per run figures include the earlier runs" << std::endl;
+    }
+}
+
+std::vector<RunResult> run_seeds(const RunConfig& config, unsigned int seed, int count, ThreadPool* pool,
+                                 const RunOutput& first_output, const RunProgress& progress)
+{
+    std::vector<RunResult> results(count > 0 ? count : 0);
+    auto body = [&](size_t run) {
+        results[run] = run_once(config, static_cast<int>(run), seed + static_cast<unsigned int>(run), run == 0 ? first_output : RunOutput());
+    };
+    if (pool)
+    {
+        reset_peak_rss_or_warn();
+        pool->parallel_for(results.size(), body);
+    }
+    else
+    {
+        for (size_t run = 0; run < results.size(); run++)
+        {
+            if (progress)
+                progress(static_cast<int>(run), nullptr);
+            reset_peak_rss_or_warn();
+            body(run);
+            if (progress)
+                progress(static_cast<int>(run), &results[run]);
+        }
+    }
+    return results;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include "Cell.hpp"
+#include "Tileset.hpp"
+#include "ImageGenerator.hpp"
+#include "Matrix.hpp"
+#include "ThreadPool.hpp"
+#include "MemoryTracker.hpp"
+#include "PerfCounters.hpp"
+#include <vector>
+#include <functional>
+
+// Everything one run needs; shared read-only by concurrent runs
+struct RunConfig
+{
+    std::string algorithm;
+    int grid_size;
+    int subgrid_size;
+    int stream_rows;       // FP_STREAM rows
+    int threads;           // Threads of the parallel algorithms
+    std::string propagation;
+    const Cell* cell;
+    const Tileset* tileset;
+    bool perf = false;     // Count hardware events of each phase (PerfCounters)
+};
+
+// Numbers of one run, kept per run so batch results stay attributable
+struct RunResult
+{
+    int run;
+    unsigned int seed;
+    double init_ms;
+    double run_ms;
+    double total_ms;
+    bool backtracking;     // Backtracks and stack memory are meaningful
+    int backtracks;
+    size_t backtrack_memory;
+    size_t memory;         // Memory usage estimated by the generator (get_memory_usage)
+    PhaseMemory init_heap; // Measured by MemoryTracker during initialization
+    PhaseMemory run_heap;  // Measured by MemoryTracker while solving
+    uint64_t peak_heap;    // Highest live heap bytes of initialization and solving together
+    size_t peak_rss;       // Process peak RSS at the end of the run, 0 when unknown
+    bool perf;             // Hardware counters were open for this run
+    PerfSample init_perf;
+    PerfSample run_perf;
+    PerfSample render_perf; // Image output (first run only)
+    size_t uncollapsed;    // FP_STREAM cells left at -1
+    size_t cells;          // Cells generated
+    uint64_t fingerprint;  // FNV-1a of the tile ids in row-major order, equal grids have equal fingerprints
+    bool known;            // False when the algorithm name is not recognised
+};
+
+// Optional side outputs of a run (only the first run has them)
+struct RunOutput
+{
+    ImageGenerator* image = nullptr; // Renders the grid when set
+    std::string image_file;
+    std::FILE* ids = nullptr;        // FP_STREAM writes raw int32 tile ids here
+};
+
+const uint64_t FINGERPRINT_BASIS = 0xcbf29ce484222325ULL;
+
+bool is_backtracking(const std::string& algorithm);
+uint64_t fingerprint_ids(uint64_t hash, const int* ids, size_t count); // Continues an FNV-1a hash over more ids
+
+// Runs the algorithm once with the given seed. Each run owns its generator, so runs are
+// independent and the grid only depends on the seed, whether runs are serial or batched
+RunResult run_once(const RunConfig& config, int run, unsigned int seed, const RunOutput& output);
+
+// Serial progress: called with result == nullptr before each run and with its result after it
+typedef std::function<void(int run, const RunResult* result)> RunProgress;
+
+// Runs seeds seed .. seed + count - 1 (run numbers 0 .. count - 1), concurrently on pool when
+// given, and returns the results in run order. Only run 0 gets first_output.
+// Serial runs restart the peak RSS before each run and report to progress; batched runs share
+// the process counters, so their heap and RSS figures include the runs executing at the same time
+std::vector<RunResult> run_seeds(const RunConfig& config, unsigned int seed, int count, ThreadPool* pool,
+                                 const RunOutput& first_output = RunOutput(), const RunProgress& progress = nullptr);
@@ -0,0 +1,228 @@
+#include "SyntheticTileset.hpp"
+#include "stb_image_write.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <sstream>
+
+const char* const SyntheticTileset::LABEL_ALPHABET = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+const char* const SyntheticTileset::PREFIX = "synthetic:";
+
+bool SyntheticTileset::is_spec(const std::string& text)
+{
+    return text.rfind(PREFIX, 0) == 0;
+}
+
+bool SyntheticTileset::parse(const std::string& spec)
+{
+    std::string fields = is_spec(spec) ? spec.substr(std::string(PREFIX).size()) : spec;
+    std::stringstream ss(fields);
+    std::string field;
+    while (std::getline(ss, field, ':'))
+    {
+        if (field.empty())
+            continue;
+        size_t eq = field.find('=');
+        std::string key = field.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : field.substr(eq + 1);
+        char* end = nullptr;
+        double number = std::strtod(value.c_str(), &end);
+        if (value.empty() || *end != '\0')
+        {
+            std::cerr << "Error: Invalid synthetic tileset field '" << field << "'" << std::endl;
+            return false;
+        }
+
+        if (key == "tiles")
+            tile_count = static_cast<int>(number);
+        else if (key == "labels")
+            label_count = static_cast<int>(number);
+        else if (key == "skew")
+            skew = number;
+        else if (key == "hardness")
+            hardness = number;
+        else if (key == "seed")
+            seed = static_cast<unsigned int>(number);
+        else
+        {
+            std::cerr << "Error: Unknown synthetic tileset field '" << key << "'" << std::endl;
+            return false;
+        }
+    }
+
+    int max_labels = static_cast<int>(std::char_traits<char>::length(LABEL_ALPHABET));
+    if (tile_count < 1 || tile_count > MAX_TILES || label_count < 1 || label_count > max_labels ||
+        skew < 0.0 || hardness < 0.0 || hardness > 1.0)
+    {
+        std::cerr << "Error: Synthetic tileset needs 1 <= tiles <= " << MAX_TILES << ", 1 <= labels <= " << max_labels
+                  << ", skew >= 0 and 0 <= hardness <= 1" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string SyntheticTileset::name() const
+{
+    std::ostringstream out;
+    out << "synthetic_t" << tile_count << "_l" << label_count << "_s" << skew << "_h" << hardness << "_r" << seed;
+    return out.str();
+}
+
+size_t SyntheticTileset::tileset_bytes(const std::vector<std::string>& names)
+{
+    // Compatible pairs: tiles sharing a label on opposite edges (name order N, S, E, W)
+    size_t counts[4][256] = {};
+    for (const std::string& name : names)
+    {
+        for (int side = 0; side < 4; side++)
+        {
+            counts[side][static_cast<unsigned char>(name[side])]++;
+        }
+    }
+    size_t pairs = 0;
+    for (int label = 0; label < 256; label++)
+    {
+        pairs += counts[0][label] * counts[1][label] + counts[2][label] * counts[3][label];
+    }
+
+    size_t n = names.size();
+    size_t mask_bytes = 4 * n * ((n + 63) / 64) * sizeof(uint64_t);
+    size_t list_bytes = 2 * pairs * sizeof(uint16_t); // Each pair is listed from both sides
+    size_t overhead = 8 * n * sizeof(std::vector<uint16_t>);
+    return mask_bytes + list_bytes + overhead;
+}
+
+bool SyntheticTileset::generate(std::vector<std::string>& names) const
+{
+    std::mt19937 rng(seed);
+
+    // Zipf label frequencies: label k is drawn with weight 1 / (k + 1)^skew
+    std::vector<double> weights(label_count);
+    for (int k = 0; k < label_count; k++)
+    {
+        weights[k] = 1.0 / std::pow(k + 1.0, skew);
+    }
+    std::discrete_distribution<int> draw(weights.begin(), weights.end());
+
+    // The first tiles cover distinct (north, west) pairs, the rest are drawn freely
+    std::vector<int> pairs(static_cast<size_t>(label_count) * label_count);
+    for (size_t p = 0; p < pairs.size(); p++)
+    {
+        pairs[p] = static_cast<int>(p);
+    }
+    std::shuffle(pairs.begin(), pairs.end(), rng);
+    size_t covered = static_cast<size_t>(std::llround((1.0 - hardness) * pairs.size()));
+    covered = std::min(covered, static_cast<size_t>(tile_count));
+
+    int digits = std::max(4, static_cast<int>(std::to_string(tile_count - 1).size()));
+    names.clear();
+    names.reserve(tile_count);
+    for (int i = 0; i < tile_count; i++)
+    {
+        int north, west;
+        if (static_cast<size_t>(i) < covered)
+        {
+            north = pairs[i] / label_count;
+            west = pairs[i] % label_count;
+        }
+        else
+        {
+            north = draw(rng);
+            west = draw(rng);
+        }
+        int south = draw(rng);
+        int east = draw(rng);
+
+        std::string index = std::to_string(i);
+        std::string name = {LABEL_ALPHABET[north], LABEL_ALPHABET[south], LABEL_ALPHABET[east], LABEL_ALPHABET[west], '_'};
+        name += std::string(digits - index.size(), '0') + index;
+        names.push_back(name);
+    }
+
+    std::sort(names.begin(), names.end());
+
+    size_t bytes = tileset_bytes(names);
+    if (bytes > MAX_TILESET_BYTES)
+    {
+        std::cerr << "Error: Synthetic tileset " << name() << " needs about " << bytes / (1024 * 1024)
+                  << " MB of adjacency tables (limit " << MAX_TILESET_BYTES / (1024 * 1024)
+                  << " MB); use fewer tiles or more labels" << std::endl;
+        names.clear();
+        return false;
+    }
+    return true;
+}
+
+bool SyntheticTileset::write_folder(const std::string& folder, int tile_size) const
+{
+    std::vector<std::string> names;
+    if (!generate(names))
+        return false;
+
+    std::error_code error;
+    if (std::filesystem::exists(folder, error) && !std::filesystem::is_empty(folder, error))
+    {
+        std::cerr << "Error: " << folder << " already exists and is not empty" << std::endl;
+        return false;
+    }
+    std::filesystem::create_directories(folder, error);
+    if (error)
+    {
+        std::cerr << "Error: Could not create " << folder << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    // Each edge is drawn as a triangle in the color of its label, so matching edges meet seamlessly
+    std::vector<unsigned char> pixels(static_cast<size_t>(tile_size) * tile_size * 3);
+    for (const std::string& name : names)
+    {
+        for (int y = 0; y < tile_size; y++)
+        {
+            for (int x = 0; x < tile_size; x++)
+            {
+                int flipped = tile_size - 1 - x;
+                char label;
+                if (y < x && y < flipped)
+                    label = name[0];           // North
+                else if (y > x && y > flipped)
+                    label = name[1];           // South
+                else if (x > y)
+                    label = name[2];           // East
+                else
+                    label = name[3];           // West
+
+                int code = static_cast<int>(std::char_traits<char>::find(LABEL_ALPHABET, label_count, label) - LABEL_ALPHABET);
+                unsigned char* pixel = pixels.data() + (static_cast<size_t>(y) * tile_size + x) * 3;
+                pixel[0] = static_cast<unsigned char>(40 + code * 97 % 216);
+                pixel[1] = static_cast<unsigned char>(40 + code * 57 % 216);
+                pixel[2] = static_cast<unsigned char>(40 + code * 151 % 216);
+            }
+        }
+
+        std::string path = folder + "/" + name + ".png";
+        if (!stbi_write_png(path.c_str(), tile_size, tile_size, 3, pixels.data(), tile_size * 3))
+        {
+            std::cerr << "Error: Could not write " << path << std::endl;
+            return false;
+        }
+    }
+
+    std::cout << "Wrote " << tile_count << " tiles with " << label_count << " labels to " << folder << std::endl;
+    return true;
+}
+
+SyntheticTileset::SyntheticTileset()
+{
+    tile_count = 256;
+    label_count = 8;
+    skew = 0.0;
+    hardness = 0.0;
+    seed = 1;
+}
+
+SyntheticTileset::~SyntheticTileset()
+{
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Generated tileset for scaling benchmarks, far larger than the bundled ones.
+// Each tile is named like the bundled tiles (edge labels N, S, E, W) plus a
+// unique suffix, e.g. "AbCA_0042", so Reader::generate_domain reads the labels
+// from the first four characters and the names can also be written as a PNG
+// folder (tilegen) that Reader::read_files loads.
+//
+// Knobs:
+//   tiles     number of tiles, at most MAX_TILES
+//   labels    size of the edge label alphabet, at most LABEL_ALPHABET characters
+//   skew      Zipf exponent of the label frequencies, 0 = uniform
+//   hardness  0..1, share of (north, west) label pairs that get no guaranteed tile.
+//             At 0 every pair has a tile (when tiles >= labels^2), so a row-major
+//             scan never runs out of candidates; at 1 every edge is random and
+//             contradictions become frequent
+//   seed      generator seed
+//
+// In place of a folder, main and bench accept the spec
+//   synthetic:tiles=2000:labels=16:skew=1:hardness=0.2:seed=1
+// (any field may be left out) and build the tileset in memory.
+//
+// The adjacency tables of Tileset grow with tiles^2: allowed_mask takes tiles^2 / 2 bytes and
+// allowed two bytes per compatible pair, which dominates with few labels (about 8 * tiles^2 /
+// labels bytes). generate refuses tilesets whose tables would exceed MAX_TILESET_BYTES; at
+// 16384 tiles and 16 labels they take about 270 MB.
+class SyntheticTileset
+{
+private:
+
+public:
+    static const char* const LABEL_ALPHABET;
+    static const char* const PREFIX; // "synthetic:"
+    static const int MAX_TILES = 16384;
+    static const size_t MAX_TILESET_BYTES = size_t(1) << 30;
+
+    int tile_count;
+    int label_count;
+    double skew;
+    double hardness;
+    unsigned int seed;
+
+    static bool is_spec(const std::string& text);
+    bool parse(const std::string& spec);
+    std::string name() const; // File and report friendly, e.g. "synthetic_t2000_l16_s1_h0.2_r1"
+    // Tile names in the sorted order of Reader::read_files; false when the tables are too large
+    bool generate(std::vector<std::string>& names) const;
+    static size_t tileset_bytes(const std::vector<std::string>& names); // Estimated Tileset adjacency tables
+    bool write_folder(const std::string& folder, int tile_size) const;
+    SyntheticTileset();
+    ~SyntheticTileset();
+};
@@ -0,0 +1,113 @@
+#include "ThreadPool.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+ThreadPool::ThreadPool(int threads, bool pin)
+{
+    if (threads <= 0)
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads <= 0)
+        threads = 1;
+
+    body = nullptr;
+    count = 0;
+    next = 0;
+    active = 0;
+    generation = 0;
+    stopping = false;
+    pinned = pin;
+
+    // The calling thread is participant 0, so workers take CPUs 1 .. threads - 1
+    for (int t = 1; t < threads; t++)
+        workers.emplace_back(&ThreadPool::worker_loop, this, t);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& body)
+{
+    if (count == 0)
+        return;
+
+    // Not worth waking anyone for a single iteration
+    if (workers.empty() || count == 1)
+    {
+        for (size_t i = 0; i < count; i++)
+            body(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->body = &body;
+        this->count = count;
+        next = 0;
+        active = static_cast<int>(workers.size());
+        generation++;
+    }
+    wake.notify_all();
+
+    drain();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return active == 0; });
+    this->body = nullptr;
+}
+
+void ThreadPool::drain()
+{
+    for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+        (*body)(i);
+}
+
+bool ThreadPool::pin_current_thread(int cpu)
+{
+#ifdef __linux__
+    int cpus = static_cast<int>(std::thread::hardware_concurrency());
+    if (cpus <= 0)
+        return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % cpus, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+void ThreadPool::worker_loop(int index)
+{
+    if (pinned)
+        pin_current_thread(index);
+
+    uint64_t seen = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+
+        drain();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--active == 0)
+            finished.notify_one();
+    }
+}
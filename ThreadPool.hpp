@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed set of worker threads for data-parallel loops. The calling thread
+// takes part in every loop, so a pool of size 1 runs everything inline.
+class ThreadPool
+{
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;     // New loop published or pool stopping
+    std::condition_variable finished; // Last worker left the current loop
+    const std::function<void(size_t)>* body; // Loop body of the current generation
+    size_t count;                     // Iterations of the current loop
+    std::atomic<size_t> next;         // Next iteration to hand out
+    int active;                       // Workers still inside the current loop
+    uint64_t generation;              // Bumped for every loop
+    bool stopping;
+    bool pinned;                      // Worker t runs on CPU t
+
+    void worker_loop(int index);
+    void drain();
+
+public:
+    explicit ThreadPool(int threads, bool pin = false); // threads <= 0 uses every hardware thread
+    ~ThreadPool();
+
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+
+    // Runs body(0) .. body(count - 1) across the pool and returns when all are done
+    void parallel_for(size_t count, const std::function<void(size_t)>& body);
+
+    // Restricts the calling thread to one CPU (modulo the CPU count). Linux only, false elsewhere
+    static bool pin_current_thread(int cpu);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+};
@@ -1,39 +1,24 @@
 #include "Tile.hpp"
 
-void Tile::set_tile_constraints(std::string constraints, std::string id)
+void Tile::set_tile_constraints(uint16_t id, uint8_t north, uint8_t south, uint8_t east, uint8_t west)
 {
     this->id = id;
-    north = constraints[0];
-    south = constraints[1];
-    east = constraints[2];
-    west = constraints[3];
+    this->north = north;
+    this->south = south;
+    this->east = east;
+    this->west = west;
 }
 
-void Tile::print_tile_constraints(void)
+void Tile::print_tile_constraints(void) const
 {
     std::cout << "ID: " << id << std::endl;
-    std::cout << "North: " << north << std::endl;
-    std::cout << "South: " << south << std::endl;
-    std::cout << "East: " << east << std::endl;
-    std::cout << "West: " << west << std::endl;
+    std::cout << "North: " << static_cast<int>(north) << std::endl;
+    std::cout << "South: " << static_cast<int>(south) << std::endl;
+    std::cout << "East: " << static_cast<int>(east) << std::endl;
+    std::cout << "West: " << static_cast<int>(west) << std::endl;
 }
 
 size_t Tile::get_memory_usage() const
 {
-    size_t size = 0;
-    size += sizeof(*this); // Base object size
-    size += id.capacity(); // String memory
-    size += north.capacity();
-    size += south.capacity();
-    size += east.capacity();
-    size += west.capacity();
-    return size;
+    return sizeof(*this); // No heap-owned members
 }
-
-Tile::Tile(/* args */)
-{
-}
-
-Tile::~Tile()
-{
-}
\ No newline at end of file
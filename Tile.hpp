@@ -1,23 +1,24 @@
 #pragma once
 
 #include <iostream>
-#include <vector>
-#include <string>
+#include <cstdint>
+#include <type_traits>
 
+// Plain tile record: the tile index plus the interned code of each edge label.
+// Label codes are assigned by Reader::generate_domain, so two edges match
+// exactly when their codes are equal.
 class Tile
 {
-private:
-    
 public:
-    std::string id;
-    std::string north;
-    std::string south;
-    std::string east;
-    std::string west;
+    uint16_t id;
+    uint8_t north;
+    uint8_t south;
+    uint8_t east;
+    uint8_t west;
 
-    void set_tile_constraints(std::string constraints, std::string id);
-    void print_tile_constraints(void);
+    void set_tile_constraints(uint16_t id, uint8_t north, uint8_t south, uint8_t east, uint8_t west);
+    void print_tile_constraints(void) const;
     size_t get_memory_usage() const;
-    Tile(/* args */);
-    ~Tile();
-};
\ No newline at end of file
+};
+
+static_assert(std::is_trivial<Tile>::value && std::is_standard_layout<Tile>::value, "Tile must stay POD");
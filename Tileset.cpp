@@ -0,0 +1,113 @@
+#include "Tileset.hpp"
+#include <algorithm>
+
+void Tileset::build(const std::vector<Tile>& tiles)
+{
+    this->tiles = tiles;
+    num_tiles = static_cast<int>(tiles.size());
+
+    // Tiles grouped by edge label, used by label-count propagation
+    num_labels = 0;
+    for (int t = 0; t < num_tiles; t++)
+        for (int dir = 0; dir < 4; dir++)
+            num_labels = std::max(num_labels, edge(t, dir) + 1);
+
+    for (int dir = 0; dir < 4; dir++)
+    {
+        with_label[dir].assign(num_labels, Domain());
+        for (int l = 0; l < num_labels; l++)
+            with_label[dir][l].reset(num_tiles);
+        for (int t = 0; t < num_tiles; t++)
+            with_label[dir][edge(t, dir)].add(t);
+    }
+
+    // Edges match by label equality on the shared side: b fits in direction dir of a exactly
+    // when the edge of b facing back has the label of the edge of a facing dir
+    for (int dir = 0; dir < 4; dir++)
+    {
+        allowed[dir].assign(num_tiles, std::vector<uint16_t>());
+        allowed_mask[dir].assign(num_tiles, Domain());
+
+        for (int a = 0; a < num_tiles; a++)
+        {
+            const Domain& fits = with_label[opposite(dir)][edge(a, dir)];
+            allowed_mask[dir][a] = fits;
+            allowed[dir][a].reserve(fits.size());
+            fits.for_each([&](int b) { allowed[dir][a].push_back(static_cast<uint16_t>(b)); });
+        }
+    }
+
+    // Candidate lists for row-major FP: a cell only depends on the tile above and the tile to the left
+    int keys = num_labels + 1;
+    candidate_offsets.assign(static_cast<size_t>(keys) * keys + 1, 0);
+    candidates.clear();
+    for (int north = 0; north < keys; north++)
+    {
+        for (int west = 0; west < keys; west++)
+        {
+            candidate_offsets[static_cast<size_t>(north) * keys + west] = static_cast<uint32_t>(candidates.size());
+            for (int t = 0; t < num_tiles; t++)
+            {
+                if ((north == num_labels || tiles[t].north == north) && (west == num_labels || tiles[t].west == west))
+                    candidates.push_back(static_cast<uint16_t>(t));
+            }
+        }
+    }
+    candidate_offsets.back() = static_cast<uint32_t>(candidates.size());
+}
+
+void Tileset::print_compatibility(void) const
+{
+    const char* names[4] = { "North", "East", "South", "West" };
+    std::cout << "======== COMPATIBILITY ========" << std::endl;
+    for (int a = 0; a < num_tiles; a++)
+    {
+        std::cout << "Tile " << a << std::endl;
+        for (int dir = 0; dir < 4; dir++)
+        {
+            std::cout << "  " << names[dir] << ":";
+            for (auto b : allowed[dir][a])
+            {
+                std::cout << " " << b;
+            }
+            std::cout << std::endl;
+        }
+    }
+    std::cout << "===============================" << std::endl;
+}
+
+size_t Tileset::get_memory_usage() const
+{
+    size_t size = 0;
+    size += sizeof(*this);
+    size += tiles.capacity() * sizeof(Tile);
+    size += candidate_offsets.capacity() * sizeof(uint32_t);
+    size += candidates.capacity() * sizeof(uint16_t);
+    for (int dir = 0; dir < 4; dir++)
+    {
+        size += allowed[dir].capacity() * sizeof(std::vector<uint16_t>);
+        for (const auto& list : allowed[dir])
+        {
+            size += list.capacity() * sizeof(uint16_t);
+        }
+        for (const auto& mask : allowed_mask[dir])
+        {
+            size += mask.get_memory_usage();
+        }
+        for (const auto& mask : with_label[dir])
+        {
+            size += mask.get_memory_usage();
+        }
+    }
+    return size;
+}
+
+Tileset::Tileset()
+{
+    num_tiles = 0;
+    num_labels = 0;
+}
+
+Tileset::~Tileset()
+{
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "Tile.hpp"
+#include "Domain.hpp"
+
+// Direction indices shared by every engine (same order as the WFC dRow/dColumn offsets)
+enum Direction
+{
+    NORTH = 0,
+    EAST = 1,
+    SOUTH = 2,
+    WEST = 3
+};
+
+inline int opposite(int direction)
+{
+    return (direction + 2) % 4;
+}
+
+// Adjacency rules of a tileset, computed once at load time.
+// Tile b may be placed in direction dir of tile a when b is in allowed[dir][a]
+// (allowed_mask[dir][a] as a bitset). Edges match by label equality, so the
+// relation is symmetric: b in allowed[dir][a] exactly when a in allowed[opposite(dir)][b].
+class Tileset
+{
+private:
+    
+public:
+    int num_tiles;
+    std::vector<Tile> tiles;
+    std::vector<std::vector<uint16_t>> allowed[4]; // allowed[dir][a]: every b that may sit in direction dir of a, ascending
+    std::vector<Domain> allowed_mask[4]; // Same sets as allowed, as domain bitsets (support masks)
+    int num_labels; // Interned edge labels are 0 .. num_labels - 1
+    std::vector<Domain> with_label[4]; // with_label[dir][l]: every tile whose edge facing dir has label l
+    std::vector<uint32_t> candidate_offsets; // Start of each (north, west) list in candidates, plus an end sentinel
+    std::vector<uint16_t> candidates; // Tile ids grouped by (north label, west label), ascending within a group
+
+    void build(const std::vector<Tile>& tiles);
+    void print_compatibility(void) const;
+    size_t get_memory_usage() const;
+    Tileset();
+    ~Tileset();
+
+    // Label of the tile edge facing direction
+    int edge(int tile, int direction) const
+    {
+        const Tile& t = tiles[tile];
+        switch (direction)
+        {
+            case NORTH: return t.north;
+            case EAST:  return t.east;
+            case SOUTH: return t.south;
+            default:    return t.west;
+        }
+    }
+
+    // Tiles whose north edge has label north and west edge has label west, in id order.
+    // The label num_labels stands for an unconstrained side.
+    const uint16_t* candidates_for(int north, int west, int& count) const
+    {
+        size_t key = static_cast<size_t>(north) * (num_labels + 1) + west;
+        count = static_cast<int>(candidate_offsets[key + 1] - candidate_offsets[key]);
+        return candidates.data() + candidate_offsets[key];
+    }
+};
@@ -0,0 +1,19 @@
+#include "Trail.hpp"
+
+void Trail::clear()
+{
+    entries.clear();
+}
+
+size_t Trail::get_memory_usage() const
+{
+    return sizeof(*this) + entries.capacity() * sizeof(TrailEntry);
+}
+
+Trail::Trail()
+{
+}
+
+Trail::~Trail()
+{
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// One undoable change to a Matrix cell: a domain word or, when word is -1,
+// the collapsed id. old holds the value before the change.
+struct TrailEntry {
+    size_t cell;
+    int word;
+    uint64_t old;
+};
+
+// Undo log for backtracking. Backtrack states remember the trail size
+// (a level marker) and Matrix::rollback undoes every entry above it, so the
+// cost of a saved state scales with the cells changed since, not the grid size.
+class Trail
+{
+private:
+    
+public:
+    std::vector<TrailEntry> entries;
+
+    size_t mark() const { return entries.size(); }
+    void record(size_t cell, int word, uint64_t old) { entries.push_back({ cell, word, old }); }
+    void clear();
+    size_t get_memory_usage() const;
+    Trail();
+    ~Trail();
+};
@@ -3,12 +3,24 @@
 #include <algorithm>
 #include <iostream>
 
-void WFC::initialize_wfc(int rows, int columns, Cell c, unsigned int seed)
+// Offsets indexed by Direction (NORTH, EAST, SOUTH, WEST)
+static const int dRow[4] = { -1,  0, +1,  0 };
+static const int dColumn[4] = {  0, +1,  0, -1 };
+
+void WFC::initialize_wfc(int rows, int columns, Cell c, const Tileset& tileset, unsigned int seed)
 {
     this->rows = rows;
     this->columns = columns;
+    this->tileset = &tileset;
     rng.seed(seed);
     matrix.initialize_matrix(rows, columns, c);
+    matrix.trail = nullptr;
+    trail.clear();
+    entropy.disable();
+    support.reset(tileset.num_tiles);
+    counters_ready = false;
+    removals.clear();
+    ac4_result = { false, -1, -1 };
     
     // Initialize backtracking variables
     backtrack_count = 0;
@@ -26,6 +38,38 @@ void WFC::run(std::string heuristic)
         Diag();
 }
 
+bool WFC::supports_propagation(const std::string& mode, const Tileset& tileset)
+{
+    if (mode != "AC3" && mode != "AC4" && mode != "LABEL")
+    {
+        std::cerr << "Error: Unknown propagation '" << mode << "'" << std::endl;
+        return false;
+    }
+    // Label sets are kept as one 64-bit mask per cell and direction
+    if (mode == "LABEL" && tileset.num_labels > 64)
+    {
+        std::cerr << "Error: LABEL propagation supports at most 64 edge labels, tileset has " << tileset.num_labels << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool WFC::set_propagation(std::string mode)
+{
+    if (tileset ? !supports_propagation(mode, *tileset) : mode != "AC3" && mode != "AC4" && mode != "LABEL")
+        return false;
+
+    if (mode == "AC3")
+        propagation = PROPAGATION_AC3;
+    else if (mode == "AC4")
+        propagation = PROPAGATION_AC4;
+    else
+        propagation = PROPAGATION_LABEL;
+
+    counters_ready = false;
+    return true;
+}
+
 void WFC::MRV()
 {
     MRV(false); // Default to no backtracking
@@ -33,54 +77,42 @@ void WFC::MRV()
 
 void WFC::MRV(bool backtrack)
 {
+    // Only log domain changes when they may have to be undone
+    matrix.trail = backtrack ? &trail : nullptr;
+
+    // Buckets by domain size replace the full-grid scan for the smallest domain
+    entropy.enable(matrix);
+
+    // Tiles that start without support go before any state can be saved
+    propagate_all();
+
     while (true)
     {
-        int smallest_domain = INT_MAX;
-        int r = -1;
-        int c = -1;
-
-        for (int i = 0; i < rows; i++)
+        // Check for empty domain
+        if (entropy.has_contradiction())
         {
-            for (int j = 0; j < columns; j++)
+            if (backtrack && !state_stack.empty())
             {
-                // Skip already collapsed cells
-                if (matrix.matrix[i][j].collapsed != -1)
+                if (!backtrack_restore())
                 {
-                    continue;
-                }
-
-                int domain_size = matrix.matrix[i][j].domain.size(); // Entropy
-
-                // Check for empty domain
-                if (domain_size == 0)
-                {
-                    if (backtrack && !state_stack.empty())
-                    {
-                        if (!backtrack_restore())
-                        {
-                            return; // Failed to find solution
-                        }
-                        continue; // Restart the loop after backtracking
-                    }
-                    else
-                    {
-                        return; // No backtracking enabled or no states to restore, exit
-                    }
-                }
-
-                // Find cell with minimum entropy
-                if (smallest_domain > domain_size)
-                {
-                    smallest_domain = domain_size;
-                    r = i;
-                    c = j;
+                    return; // Failed to find solution
                 }
+                continue; // Restart the loop after backtracking
+            }
+            else
+            {
+                return; // No backtracking enabled or no states to restore, exit
             }
         }
 
-        if (r == -1)
+        // Find cell with minimum entropy
+        long long picked = entropy.pick(rng);
+        if (picked == -1)
             break; // All cells are collapsed
 
+        int r = static_cast<int>(picked / columns);
+        int c = static_cast<int>(picked % columns);
+
         // Collapse with or without backtracking
         if (backtrack)
         {
@@ -109,15 +141,15 @@ void WFC::MRV(bool backtrack)
                 }
                 
                 // Propagate constraints
-                propagate(r, c);
+                PropagationResult result = propagate(r, c);
                 
                 // Check for contradictions after propagation
-                if (has_empty_domains()) {
-                    // If propagation caused empty domains, we need to backtrack
+                if (result.contradiction) {
+                    // If propagation wiped out a domain, we need to backtrack
                     success = false;
                     if (!state_stack.empty()) {
                         if (!backtrack_restore()) {
-                            std::cerr << "Error: Unable to solve - propagation caused unsolvable state at (" << r << "," << c << ")" << std::endl;
+                            std::cerr << "Error: Unable to solve - propagation caused unsolvable state at (" << r << "," << c << "), domain wiped out at (" << result.row << "," << result.col << ")" << std::endl;
                             return;
                         }
                     } else {
@@ -144,6 +176,10 @@ void WFC::Diag()
 
 void WFC::Diag(bool backtrack)
 {
+    matrix.trail = backtrack ? &trail : nullptr;
+
+    propagate_all();
+
     // Anti-diagonais: (0,0) -> (0,1), (1,0) -> (0,2), (1,1), (2,0) -> etc.
     for (int diagonal = 0; diagonal < rows + columns - 1; ++diagonal)
     {
@@ -158,7 +194,7 @@ void WFC::Diag(bool backtrack)
             if (col >= 0 && col < columns)
             {
                 // Check if cell is already collapsed
-                if (matrix.matrix[row][col].collapsed != -1)
+                if (matrix.collapsed[matrix.index(row, col)] != -1)
                     continue;
                 
                 bool success = false;
@@ -191,14 +227,14 @@ void WFC::Diag(bool backtrack)
                     }
                     
                     // Propagate constraints
-                    propagate(row, col);
+                    PropagationResult result = propagate(row, col);
                     
-                    if (backtrack && has_empty_domains()) {
-                        // If propagation caused empty domains, we need to backtrack
+                    if (backtrack && result.contradiction) {
+                        // If propagation wiped out a domain, we need to backtrack
                         success = false;
                         if (!state_stack.empty()) {
                             if (!backtrack_restore()) {
-                                std::cerr << "Error: Unable to solve - propagation caused unsolvable state at (" << row << "," << col << ")" << std::endl;
+                                std::cerr << "Error: Unable to solve - propagation caused unsolvable state at (" << row << "," << col << "), domain wiped out at (" << result.row << "," << result.col << ")" << std::endl;
                                 return;
                             }
                         } else {
@@ -216,41 +252,95 @@ void WFC::Diag(bool backtrack)
 
 void WFC::collapse(int i, int j)
 {
-    int size = matrix.matrix[i][j].domain.size();
+    size_t idx = matrix.index(i, j);
+    int size = matrix.domain_sizes[idx];
+    if (size == 0)
+        return; // Contradiction: nothing to pick, the cell stays uncollapsed
+
     std::uniform_int_distribution<std::size_t> dist(0, size - 1);
     int choice = dist(rng);
 
-    Tile pickedValue = matrix.matrix[i][j].domain[choice];
-    matrix.matrix[i][j].domain.clear();
-    matrix.matrix[i][j].domain.push_back(pickedValue);
-    matrix.matrix[i][j].collapsed = std::stoi(pickedValue.id);
+    assign(idx, bits_nth(matrix.domain(idx), matrix.words, choice));
 
     //std::cout << "Colapsando " << i << " " << j << std::endl;
 }
 
 
-// Exemplo de teste de compatibilidade; adapte aos seus campos:
-bool is_compatible(const Tile& t_from, const Tile& t_to, int direction) {
-    // se direction == 0 (Norte), testamos t_from.north vs t_to.south, etc.
-    switch(direction) {
-        case 0: return t_from.north == t_to.south;
-        case 1: return t_from.east  == t_to.west;
-        case 2: return t_from.south == t_to.north;
-        case 3: return t_from.west  == t_to.east;
+void WFC::assign(size_t idx, int tile)
+{
+    if (propagation == PROPAGATION_AC4)
+    {
+        build_supports();
+
+        // Every other tile loses its place here, withdraw the supports it gave
+        support.bits.assign(matrix.domain(idx), matrix.domain(idx) + matrix.words);
+        support.for_each([&](int other) {
+            if (other != tile)
+                ban(idx, other);
+        });
     }
-    return false;
+    else if (propagation == PROPAGATION_LABEL)
+    {
+        build_label_counts();
+        const uint64_t* domain = matrix.domain(idx);
+        for (int w = 0; w < matrix.words; w++)
+        {
+            uint64_t others = domain[w];
+            if (w == (tile >> 6))
+                others &= ~(uint64_t(1) << (tile & 63));
+            count_labels(idx, w, others, -1);
+        }
+    }
+
+    matrix.assign_single(idx, tile);
+    entropy.remove(idx);
+}
+
+PropagationResult WFC::propagate(int start_i, int start_j)
+{
+    if (propagation == PROPAGATION_AC4)
+        return propagate_ac4();
+    if (propagation == PROPAGATION_LABEL)
+        return propagate_labels(start_i, start_j);
+    return propagate_ac3(start_i, start_j);
 }
 
-void WFC::propagate(int start_i, int start_j)
+PropagationResult WFC::propagate_all()
 {
-    const int dRow[4] = { -1,  0, +1,  0 };
-    const int dColumn[4] = {  0, +1,  0, -1 };
+    // AC-4 drops the tiles without initial support when it builds its counters; AC-3 and
+    // LABEL revise every arc once, so all modes start the search from the same domains
+    if (propagation == PROPAGATION_AC4)
+        return propagate_ac4();
+    if (propagation == PROPAGATION_LABEL)
+        return propagate_labels(-1, -1);
+    return propagate_ac3(-1, -1);
+}
+
+PropagationResult WFC::propagate_ac3(int start_i, int start_j)
+{
+    PropagationResult result = { false, -1, -1 };
 
     std::deque<std::tuple<int,int,int>> queue; // (linha, coluna, direção de onde veio)
-    // inicializa a fila com os 4 arcos vindos da célula colapsada
-    for (int dir = 0; dir < 4; ++dir)
+    // antes do primeiro colapso quase todas as células têm o mesmo domínio: a máscara
+    // de suporte do último vizinho em cada direção é reaproveitada quando ele não mudou
+    bool whole_grid = start_i < 0;
+    std::vector<uint64_t> last_neighbour[4];
+    std::vector<uint64_t> last_support[4];
+    if (whole_grid)
     {
-        queue.emplace_back(start_i + dRow[dir], start_j + dColumn[dir], (dir + 2) % 4 ); // direção inversa, do ponto de vista do vizinho
+        // grade inteira: cada célula contra cada vizinho, em ordem de índice
+        for (int i = 0; i < rows; ++i)
+            for (int j = 0; j < columns; ++j)
+                for (int dir = 0; dir < 4; ++dir)
+                    queue.emplace_back(i, j, dir);
+    }
+    else
+    {
+        // inicializa a fila com os 4 arcos vindos da célula colapsada
+        for (int dir = 0; dir < 4; ++dir)
+        {
+            queue.emplace_back(start_i + dRow[dir], start_j + dColumn[dir], (dir + 2) % 4 ); // direção inversa, do ponto de vista do vizinho
+        }
     }
 
     while (!queue.empty())
@@ -260,53 +350,50 @@ void WFC::propagate(int start_i, int start_j)
 
         // se não existe ou se já foi colapsada, pula
         if (i<0 || i>=rows || j<0 || j>=columns) continue;
-        if (matrix.matrix[i][j].collapsed != -1) continue;
-
-        bool revised = false;
-        auto& domain_ij = matrix.matrix[i][j].domain;
-
-        // domínio temporário para reconstruir só com padrões suportados:
-        std::vector<Tile> new_domain;
-        new_domain.reserve(domain_ij.size());
-
-        for (auto& tile_ij : domain_ij)
+        size_t idx = matrix.index(i, j);
+        if (matrix.collapsed[idx] != -1) continue;
+
+        // olha o vizinho naquela direção:
+        int ni = i + dRow[dir_from_neighbor];
+        int nj = j + dColumn[dir_from_neighbor];
+        if (ni<0 || ni>=rows || nj<0 || nj>=columns) continue; // sem vizinho, assume que sempre suporta
+
+        // um padrão tem suporte se algum padrão do vizinho for compatível com ele:
+        // une as máscaras de suporte de todos os padrões restantes no vizinho
+        const uint64_t* neighbour = matrix.domain(matrix.index(ni, nj));
+        const uint64_t* mask = support.bits.data();
+        if (whole_grid && !last_neighbour[dir_from_neighbor].empty() &&
+            std::equal(neighbour, neighbour + matrix.words, last_neighbour[dir_from_neighbor].begin()))
         {
-            bool has_support = false;
-            // olha o vizinho naquela direção:
-            int ni = i + dRow[dir_from_neighbor];
-            int nj = j + dColumn[dir_from_neighbor];
-            if (ni<0 || ni>=rows || nj<0 || nj>=columns)
-            {
-                // sem vizinho, assume que sempre suporta
-                has_support = true;
-            }
-            else
-            {
-                const auto& domain_n = matrix.matrix[ni][nj].domain;
-                // se ao menos um padrão no vizinho for compatível:
-                for (auto& tile_n : domain_n)
-                {
-                    if (is_compatible(tile_ij, tile_n, dir_from_neighbor))
-                    {
-                        has_support = true;
-                        break;
-                    }
-                }
-            }
-            if (has_support)
-            {
-                new_domain.push_back(tile_ij);
-            }
-            else
+            mask = last_support[dir_from_neighbor].data();
+        }
+        else
+        {
+            const auto& allowed_mask = tileset->allowed_mask[opposite(dir_from_neighbor)];
+            support.clear();
+            bits_for_each(neighbour, matrix.words, [&](int tile_n) { support.unite(allowed_mask[tile_n]); });
+            if (whole_grid)
             {
-                revised = true;
+                last_neighbour[dir_from_neighbor].assign(neighbour, neighbour + matrix.words);
+                last_support[dir_from_neighbor] = support.bits;
             }
         }
 
+        // revisão do domínio: um AND com a máscara, sem alocação
+        bool revised = matrix.restrict_domain(idx, mask);
+
         if (revised)
         {
-            // domínio mudou: aplica a nova lista
-            domain_ij.swap(new_domain);
+            entropy.update(idx, matrix.domain_sizes[idx]);
+
+            if (matrix.domain_sizes[idx] == 0 && !result.contradiction)
+            {
+                result = { true, i, j };
+
+                // With a trail this step is about to be rolled back, stop here
+                if (matrix.trail)
+                    return result;
+            }
 
             // reenfileira todos os arcos vindos dos demais vizinhos
             for (int dir2 = 0; dir2 < 4; ++dir2)
@@ -322,10 +409,244 @@ void WFC::propagate(int start_i, int start_j)
     } 
 
     //std::cout << "Propagation Ended!" << std::endl;
+    return result;
+}
+
+PropagationResult WFC::propagate_labels(int start_i, int start_j)
+{
+    PropagationResult result = { false, -1, -1 };
+    build_label_counts();
+
+    std::deque<std::pair<size_t, int>> queue; // (cell, direction of the neighbour it is revised against)
+    if (start_i < 0)
+    {
+        // Whole grid, in the order propagate_ac3 queues it
+        for (int i = 0; i < rows; ++i)
+            for (int j = 0; j < columns; ++j)
+                for (int dir = 0; dir < 4; ++dir)
+                {
+                    int ni = i + dRow[dir];
+                    int nj = j + dColumn[dir];
+                    if (ni < 0 || ni >= rows || nj < 0 || nj >= columns) continue;
+                    queue.emplace_back(matrix.index(i, j), dir);
+                }
+    }
+    else
+    {
+        for (int dir = 0; dir < 4; ++dir)
+        {
+            int ni = start_i + dRow[dir];
+            int nj = start_j + dColumn[dir];
+            if (ni < 0 || ni >= rows || nj < 0 || nj >= columns) continue;
+            queue.emplace_back(matrix.index(ni, nj), opposite(dir));
+        }
+    }
+
+    while (!queue.empty())
+    {
+        auto [idx, dir] = queue.front();
+        queue.pop_front();
+        if (matrix.collapsed[idx] != -1) continue;
+
+        int i = static_cast<int>(idx / columns);
+        int j = static_cast<int>(idx % columns);
+        size_t nidx = matrix.index(i + dRow[dir], j + dColumn[dir]);
+
+        // A tile keeps its support while the neighbour still offers the label on its edge.
+        // Every label here already being offered means there is nothing to remove.
+        uint64_t offered = label_masks[nidx * 4 + opposite(dir)];
+        uint64_t missing = label_masks[idx * 4 + dir] & ~offered;
+        if (!missing)
+            continue;
+
+        support.clear();
+        bits_for_each(&offered, 1, [&](int label) { support.unite(tileset->with_label[dir][label]); });
+
+        // Withdraw the removed tiles from the counts before the AND drops them
+        uint64_t* domain = matrix.domain(idx);
+        for (int w = 0; w < matrix.words; w++)
+            count_labels(idx, w, domain[w] & ~support.bits[w], -1);
+        matrix.restrict_domain(idx, support.bits.data());
+        entropy.update(idx, matrix.domain_sizes[idx]);
+
+        if (matrix.domain_sizes[idx] == 0 && !result.contradiction)
+        {
+            result = { true, i, j };
+
+            // With a trail this step is about to be rolled back, stop here
+            if (matrix.trail)
+                return result;
+        }
+
+        // Same arcs as AC-3, so both modes revise cells in the same order and produce the
+        // same grid; a neighbour this cell still fully supports leaves at the mask check
+        for (int d = 0; d < 4; d++)
+        {
+            int pi = i + dRow[d];
+            int pj = j + dColumn[d];
+            if (pi < 0 || pi >= rows || pj < 0 || pj >= columns) continue;
+            if (pi == start_i && pj == start_j) continue;
+            queue.emplace_back(matrix.index(pi, pj), opposite(d));
+        }
+    }
+    return result;
+}
+
+void WFC::build_label_counts()
+{
+    if (counters_ready)
+        return;
+    counters_ready = true;
+
+    size_t cell_count = matrix.cells();
+    label_counts.assign(cell_count * 4 * tileset->num_labels, 0);
+    label_masks.assign(cell_count * 4, 0);
+
+    for (size_t idx = 0; idx < cell_count; idx++)
+        for (int w = 0; w < matrix.words; w++)
+            count_labels(idx, w, matrix.domain(idx)[w], +1);
+}
+
+void WFC::count_labels(size_t idx, int word, uint64_t tiles, int delta)
+{
+    if (!tiles)
+        return;
+
+    // One popcount per label instead of one update per tile
+    const int num_labels = tileset->num_labels;
+    for (int dir = 0; dir < 4; dir++)
+    {
+        uint16_t* counts = &label_counts[(idx * 4 + dir) * num_labels];
+        uint64_t mask = 0;
+        for (int label = 0; label < num_labels; label++)
+        {
+            counts[label] += delta * popcount64(tiles & tileset->with_label[dir][label].bits[word]);
+            if (counts[label])
+                mask |= uint64_t(1) << label;
+        }
+        label_masks[idx * 4 + dir] = mask;
+    }
+}
+
+PropagationResult WFC::propagate_ac4()
+{
+    build_supports();
+
+    // Supports were withdrawn eagerly by ban, only the zeroed ones are left to remove.
+    // The queue always drains so the counters match the domains for rollback.
+    while (!removals.empty())
+    {
+        auto [idx, tile] = removals.back();
+        removals.pop_back();
+        if (matrix.collapsed[idx] == -1)
+            ban(idx, tile);
+    }
+
+    PropagationResult result = ac4_result;
+    ac4_result = { false, -1, -1 };
+    return result;
+}
+
+void WFC::build_supports()
+{
+    if (counters_ready)
+        return;
+    counters_ready = true;
+
+    const int num_tiles = tileset->num_tiles;
+    size_t cell_count = matrix.cells();
+    supports.assign(cell_count * num_tiles * 4, 0);
+    removals.clear();
+
+    for (size_t idx = 0; idx < cell_count; idx++)
+    {
+        int i = static_cast<int>(idx / columns);
+        int j = static_cast<int>(idx % columns);
+        uint16_t* counts = &supports[idx * num_tiles * 4];
+
+        for (int dir = 0; dir < 4; dir++)
+        {
+            int ni = i + dRow[dir];
+            int nj = j + dColumn[dir];
+            bool outside = ni < 0 || ni >= rows || nj < 0 || nj >= columns;
+            const uint64_t* neighbour = outside ? nullptr : matrix.domain(matrix.index(ni, nj));
+
+            for (int tile = 0; tile < num_tiles; tile++)
+            {
+                // Borders always support, the count never reaches zero
+                if (outside)
+                {
+                    counts[tile * 4 + dir] = 1;
+                    continue;
+                }
+                const uint64_t* mask = tileset->allowed_mask[dir][tile].bits.data();
+                int count = 0;
+                for (int w = 0; w < matrix.words; w++)
+                    count += popcount64(mask[w] & neighbour[w]);
+                counts[tile * 4 + dir] = static_cast<uint16_t>(count);
+            }
+        }
+    }
+
+    // Tiles that start without support in some direction are removed right away
+    for (size_t idx = 0; idx < cell_count; idx++)
+    {
+        if (matrix.collapsed[idx] != -1)
+            continue;
+        const uint16_t* counts = &supports[idx * num_tiles * 4];
+        for (int tile = 0; tile < num_tiles; tile++)
+        {
+            if (counts[tile * 4] == 0 || counts[tile * 4 + 1] == 0 ||
+                counts[tile * 4 + 2] == 0 || counts[tile * 4 + 3] == 0)
+                removals.emplace_back(idx, tile);
+        }
+    }
+}
+
+void WFC::ban(size_t idx, int tile)
+{
+    if (!matrix.remove_tile(idx, tile))
+        return;
+
+    entropy.update(idx, matrix.domain_sizes[idx]);
+    if (matrix.domain_sizes[idx] == 0 && !ac4_result.contradiction)
+        ac4_result = { true, static_cast<int>(idx / columns), static_cast<int>(idx % columns) };
+
+    adjust_supports(idx, tile, -1);
+}
+
+void WFC::adjust_supports(size_t idx, int tile, int delta)
+{
+    const int num_tiles = tileset->num_tiles;
+    int i = static_cast<int>(idx / columns);
+    int j = static_cast<int>(idx % columns);
+
+    for (int dir = 0; dir < 4; dir++)
+    {
+        int ni = i + dRow[dir];
+        int nj = j + dColumn[dir];
+        if (ni < 0 || ni >= rows || nj < 0 || nj >= columns) continue;
+
+        // Seen from the neighbour this cell lies in the opposite direction. By the symmetry
+        // of the adjacency rules, the tiles there that tile supported are exactly allowed[dir][tile].
+        size_t nidx = matrix.index(ni, nj);
+        uint16_t* counts = &supports[nidx * num_tiles * 4 + opposite(dir)];
+        bool open = matrix.collapsed[nidx] == -1;
+
+        for (uint16_t other : tileset->allowed[dir][tile])
+        {
+            counts[other * 4] += delta;
+            if (delta < 0 && counts[other * 4] == 0 && open)
+                removals.emplace_back(nidx, other);
+        }
+    }
 }
 
 WFC::WFC(/* args */)
 {
+    tileset = nullptr;
+    propagation = PROPAGATION_AC3;
+    counters_ready = false;
 }
 
 WFC::~WFC()
@@ -336,6 +657,9 @@ void WFC::reset_matrix(Cell c)
 {
     // Reset the matrix to initial state
     matrix.initialize_matrix(rows, columns, c);
+    trail.clear();
+    counters_ready = false;
+    removals.clear();
 }
 
 size_t WFC::get_matrix_memory_usage() const
@@ -356,6 +680,17 @@ size_t WFC::get_memory_usage() const
     // Random number generator (minimal)
     size += sizeof(rng);
     
+    // MRV entropy buckets
+    size += entropy.get_memory_usage() - sizeof(EntropyQueue);
+    
+    // AC-4 support counters and pending removals
+    size += supports.capacity() * sizeof(uint16_t);
+    size += removals.capacity() * sizeof(std::pair<size_t, int>);
+
+    // Label counts and masks
+    size += label_counts.capacity() * sizeof(uint16_t);
+    size += label_masks.capacity() * sizeof(uint64_t);
+    
     // Backtracking stack memory (current usage)
     size += get_backtrack_stack_memory_usage();
     
@@ -365,28 +700,24 @@ size_t WFC::get_memory_usage() const
 bool WFC::collapse_with_backtrack(int i, int j, const std::vector<int>& tried_tiles)
 {
     // Get available tiles that haven't been tried yet
-    std::vector<Tile> available_tiles;
-    for (const auto& tile : matrix.matrix[i][j].domain) {
-        int tile_id = std::stoi(tile.id);
-        if (std::find(tried_tiles.begin(), tried_tiles.end(), tile_id) == tried_tiles.end()) {
-            available_tiles.push_back(tile);
-        }
+    size_t idx = matrix.index(i, j);
+    Domain available_tiles = matrix.get_domain(idx);
+    for (int tile_id : tried_tiles) {
+        available_tiles.remove(tile_id);
     }
     
-    if (available_tiles.empty()) {
+    int available_count = available_tiles.size();
+    if (available_count == 0) {
         return false; // No more tiles to try
     }
     
     // Randomly select a tile from available ones
-    std::uniform_int_distribution<std::size_t> dist(0, available_tiles.size() - 1);
+    std::uniform_int_distribution<std::size_t> dist(0, available_count - 1);
     int choice = dist(rng);
-    Tile pickedValue = available_tiles[choice];
-    int collapsed_tile_id = std::stoi(pickedValue.id);
+    int collapsed_tile_id = available_tiles.nth(choice);
     
     // Perform the collapse
-    matrix.matrix[i][j].domain.clear();
-    matrix.matrix[i][j].domain.push_back(pickedValue);
-    matrix.matrix[i][j].collapsed = collapsed_tile_id;
+    assign(idx, collapsed_tile_id);
     
     // Update the state with the tile we just tried
     if (!state_stack.empty()) {
@@ -399,11 +730,10 @@ bool WFC::collapse_with_backtrack(int i, int j, const std::vector<int>& tried_ti
 
 bool WFC::has_empty_domains()
 {
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < columns; j++) {
-            if (matrix.matrix[i][j].collapsed == -1 && matrix.matrix[i][j].domain.empty()) {
-                return true;
-            }
+    size_t cell_count = matrix.cells();
+    for (size_t idx = 0; idx < cell_count; idx++) {
+        if (matrix.collapsed[idx] == -1 && matrix.domain_sizes[idx] == 0) {
+            return true;
         }
     }
     return false;
@@ -411,15 +741,20 @@ bool WFC::has_empty_domains()
 
 void WFC::save_state(int i, int j, int collapsed_tile_id)
 {
+    // Nothing below the oldest saved state can be undone, drop it
+    if (state_stack.empty()) {
+        trail.clear();
+    }
+    
     WFCBacktrackState state;
-    state.matrix_state = matrix; // Save current matrix state
+    state.trail_mark = trail.mark(); // Changes after this point are undone on restore
     state.row = i;
     state.col = j;
     state.collapsed_tile_id = -1; // Will be set when we actually try tiles
     state.tried_tiles.clear(); // Start with empty list
     
     // Calculate memory cost
-    size_t state_memory = sizeof(WFCBacktrackState) + state.matrix_state.get_memory_usage();
+    size_t state_memory = sizeof(WFCBacktrackState);
     backtrack_memory_cost += state_memory;
     
     state_stack.push(state);
@@ -436,31 +771,49 @@ bool WFC::backtrack_restore()
     WFCBacktrackState current_state = state_stack.top();
     state_stack.pop();
     
+    // Undo every change made since the state was saved
+    restore_to(current_state.trail_mark);
+    
     // Check if we have more tiles to try at this position
-    std::vector<Tile> available_tiles;
-    for (const auto& tile : current_state.matrix_state.matrix[current_state.row][current_state.col].domain) {
-        int tile_id = std::stoi(tile.id);
-        if (std::find(current_state.tried_tiles.begin(), current_state.tried_tiles.end(), tile_id) == current_state.tried_tiles.end()) {
-            available_tiles.push_back(tile);
-        }
+    Domain available_tiles = matrix.get_domain(matrix.index(current_state.row, current_state.col));
+    for (int tile_id : current_state.tried_tiles) {
+        available_tiles.remove(tile_id);
     }
     
     if (!available_tiles.empty()) {
-        // We have more tiles to try, restore state and update tried_tiles
-        matrix = current_state.matrix_state;
-        
+        // We have more tiles to try, state is restored, update tried_tiles
         // Put the state back with updated tried_tiles for next attempt
         state_stack.push(current_state);
         
         // Try to collapse with the updated tried_tiles list
         return collapse_with_backtrack(current_state.row, current_state.col, current_state.tried_tiles);
     } else {
-        // No more tiles to try at this position, restore state and continue backtracking
-        matrix = current_state.matrix_state;
+        // No more tiles to try at this position, continue backtracking
         return backtrack_restore(); // Recursive backtrack
     }
 }
 
+void WFC::restore_to(size_t trail_mark)
+{
+    bool supporting = propagation == PROPAGATION_AC4 && counters_ready;
+    bool labelling = propagation == PROPAGATION_LABEL && counters_ready;
+
+    matrix.rollback(trail_mark, [&](size_t idx, int word, uint64_t restored) {
+        entropy.restore(idx);
+
+        // Restored tiles give their supports back, the inverse of ban
+        if (supporting)
+            bits_for_each(&restored, 1, [&](int bit) { adjust_supports(idx, word * 64 + bit, +1); });
+        if (labelling)
+            count_labels(idx, word, restored, +1);
+    });
+    entropy.finish_restore(matrix);
+
+    // Pending removals and wipe-outs belonged to the undone step
+    removals.clear();
+    ac4_result = { false, -1, -1 };
+}
+
 int WFC::get_backtrack_count() const
 {
     return backtrack_count;
@@ -473,6 +826,7 @@ void WFC::reset_backtrack_count()
     while (!state_stack.empty()) {
         state_stack.pop();
     }
+    trail.clear();
 }
 
 size_t WFC::get_backtrack_memory_cost() const
@@ -487,12 +841,8 @@ size_t WFC::get_total_backtrack_impact() const
 
 size_t WFC::get_backtrack_stack_memory_usage() const
 {
-    size_t total = 0;
-    // Calculate current stack size
-    std::stack<WFCBacktrackState> temp_stack = state_stack; // Copy the stack
-    while (!temp_stack.empty()) {
-        total += sizeof(WFCBacktrackState) + temp_stack.top().matrix_state.get_memory_usage();
-        temp_stack.pop();
-    }
+    // Saved states are fixed-size markers, the undo data lives in the trail
+    size_t total = state_stack.size() * sizeof(WFCBacktrackState);
+    total += trail.get_memory_usage();
     return total;
 }
\ No newline at end of file
@@ -5,9 +5,19 @@
 #include <deque>
 #include <stack>
 #include "Matrix.hpp"
+#include "Tileset.hpp"
+#include "EntropyQueue.hpp"
+
+// Arc consistency engine used by WFC::propagate
+enum PropagationMode
+{
+    PROPAGATION_AC3, // Arc queue, each revision re-checks the whole neighbour domain
+    PROPAGATION_AC4, // Per-cell, per-tile, per-direction support counters
+    PROPAGATION_LABEL // Arc queue revised through per-direction edge label counts
+};
 
 struct WFCBacktrackState {
-    Matrix matrix_state;
+    size_t trail_mark; // Trail size when the state was saved
     int row;
     int col;
     int collapsed_tile_id;
@@ -20,22 +30,53 @@ private:
     std::stack<WFCBacktrackState> state_stack;
     int backtrack_count;
     size_t backtrack_memory_cost; // Total memory cost of all backtrack operations
+    Domain support; // Scratch mask reused by every arc revision in propagate
+    EntropyQueue entropy; // Uncollapsed cells by domain size, used by MRV
+    Trail trail; // Domain changes since the oldest saved state
+    PropagationMode propagation;
+
+    // AC-4 state: supports[(cell * num_tiles + tile) * 4 + dir] counts the tiles left in the
+    // neighbour at dir that are compatible with tile. Built lazily on first use.
+    std::vector<uint16_t> supports;
+    std::vector<std::pair<size_t, int>> removals; // (cell, tile) whose support reached zero
+    // Label state: label_counts[(cell * 4 + dir) * num_labels + l] counts the domain tiles whose
+    // edge facing dir has label l; label_masks[cell * 4 + dir] has bit l set while that count is nonzero
+    std::vector<uint16_t> label_counts;
+    std::vector<uint64_t> label_masks;
+
+    bool counters_ready; // AC-4 supports or label counts match the current grid
+    PropagationResult ac4_result; // First wipe-out since the last AC-4 propagate
+
+    void restore_to(size_t trail_mark);
+    void assign(size_t idx, int tile);
+    PropagationResult propagate_ac3(int start_i, int start_j);
+    PropagationResult propagate_ac4();
+    void build_supports();
+    void ban(size_t idx, int tile);
+    void adjust_supports(size_t idx, int tile, int delta);
+    PropagationResult propagate_labels(int start_i, int start_j);
+    void build_label_counts();
+    void count_labels(size_t idx, int word, uint64_t tiles, int delta);
     
 public:
     int rows;
     int columns;
     Matrix matrix;
+    const Tileset* tileset;
     std::mt19937 rng;
 
-    void initialize_wfc(int rows, int columns, Cell c, unsigned int seed);
+    void initialize_wfc(int rows, int columns, Cell c, const Tileset& tileset, unsigned int seed);
     void run(std::string heuristic);
+    bool set_propagation(std::string mode);
+    static bool supports_propagation(const std::string& mode, const Tileset& tileset); // Reports why not on cerr
     void Diag();
     void Diag(bool backtrack);
     void MRV();
     void MRV(bool backtrack);
     void collapse(int i, int j);
     bool collapse_with_backtrack(int i, int j, const std::vector<int>& tried_tiles = {});
-    void propagate(int i, int j);
+    PropagationResult propagate(int i, int j);
+    PropagationResult propagate_all(); // Every arc of the grid, run before the first collapse
     bool has_empty_domains();
     void save_state(int i, int j, int collapsed_tile_id);
     bool backtrack_restore();
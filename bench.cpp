@@ -0,0 +1,244 @@
+// Micro-benchmarks of the solver kernels on the bundled tilesets:
+//   wfc.propagate          one WFC::propagate after each collapse, cells in row-major order
+//   fp.collapse            one FastPropagation::collapse + propagate per cell
+//   nwfc.subgrid           NWFC::run divided by the number of subgrids (WFC setup, seeding and solve)
+//   image.generate         ImageGenerator::generate_image of a finished grid to a .ppm
+// Setup (building the generator, untimed collapses) is excluded from the timings. Every kernel
+// is repeated until it has run for --min-time ms; allocations are counted by the global
+// operator new of MemoryTracker and reported per operation, along with the highest live heap
+// above the start of a timed section.
+//
+// A synthetic spec (synthetic:tiles=2000:labels=16) is accepted as a tileset; it has no tile
+// images, so image.generate skips it.
+//
+//   bench [--min-time=ms] [--filter=texto] [--tilesets=Roads,Carcassonne] [--sizes=16,32]
+#include "Reader.hpp"
+#include "Cell.hpp"
+#include "Tileset.hpp"
+#include "FastPropagation.hpp"
+#include "WFC.hpp"
+#include "NWFC.hpp"
+#include "ImageGenerator.hpp"
+#include "SyntheticTileset.hpp"
+#include "MemoryTracker.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Accumulates the timed sections of one benchmark
+struct Measure {
+    double ns = 0.0;
+    uint64_t ops = 0;
+    uint64_t bytes = 0;
+    uint64_t allocs = 0;
+    uint64_t peak = 0;
+    uint64_t iterations = 0;
+
+    Clock::time_point start_time;
+    MemoryTracker heap;
+
+    void start() {
+        heap.begin();
+        start_time = Clock::now();
+    }
+
+    void stop(uint64_t count) {
+        auto end_time = Clock::now();
+        PhaseMemory phase = heap.end();
+        ns += std::chrono::duration<double, std::nano>(end_time - start_time).count();
+        bytes += phase.allocated_bytes;
+        allocs += phase.allocations;
+        peak = std::max(peak, phase.peak_bytes);
+        ops += count;
+    }
+};
+
+struct LoadedTileset {
+    std::string name;
+    bool synthetic = false; // No tile images
+    Reader reader;
+    Tileset tileset;
+    Cell cell;
+};
+
+static std::vector<int> parse_list(const std::string& text) {
+    std::vector<int> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty())
+            values.push_back(std::stoi(item));
+    return values;
+}
+
+static std::vector<std::string> parse_names(const std::string& text) {
+    std::vector<std::string> names;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty())
+            names.push_back(item);
+    return names;
+}
+
+// Kernels: each call runs one iteration and records its timed sections into m
+static void bench_wfc_propagate(const LoadedTileset& ts, int size, unsigned int seed, Measure& m) {
+    WFC wfc;
+    wfc.initialize_wfc(size, size, ts.cell, ts.tileset, seed);
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++) {
+            wfc.collapse(i, j);
+            m.start();
+            PropagationResult result = wfc.propagate(i, j);
+            m.stop(1);
+            if (result.contradiction)
+                return;
+        }
+    }
+}
+
+static void bench_fp_collapse(const LoadedTileset& ts, int size, unsigned int seed, Measure& m) {
+    FastPropagation fp;
+    fp.initialize_fp(size, size, ts.cell, ts.tileset, seed);
+    m.start();
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++) {
+            fp.collapse(i, j);
+            fp.propagate(i, j);
+        }
+    }
+    m.stop(static_cast<uint64_t>(size) * size);
+}
+
+static const int BENCH_SUBGRID_SIZE = 5;
+
+static void bench_nwfc_subgrid(const LoadedTileset& ts, int size, unsigned int seed, Measure& m) {
+    NWFC nwfc;
+    nwfc.initialize_nwfc(size, size, BENCH_SUBGRID_SIZE, ts.cell, ts.tileset, seed);
+    m.start();
+    nwfc.run();
+    m.stop(static_cast<uint64_t>(size) * size);
+}
+
+static void bench_generate_image(const LoadedTileset& ts, int size, unsigned int seed, Measure& m) {
+    static std::map<std::string, ImageGenerator> generators; // Tiles are decoded once per tileset
+    auto found = generators.find(ts.name);
+    if (found == generators.end()) {
+        found = generators.emplace(std::piecewise_construct, std::forward_as_tuple(ts.name), std::forward_as_tuple()).first;
+        found->second.initialize(ts.reader, ts.name);
+        found->second.set_threads(1);
+    }
+
+    FastPropagation fp;
+    fp.initialize_fp_table(size, size, ts.tileset, seed);
+    fp.run("Table");
+    m.start();
+    found->second.generate_image(fp.matrix, "bench_render.ppm");
+    m.stop(1);
+}
+
+struct Kernel {
+    const char* name;
+    void (*run)(const LoadedTileset& ts, int size, unsigned int seed, Measure& m);
+    std::vector<int> sizes; // Grid side, in subgrids for nwfc.subgrid
+};
+
+int main(int argc, char const *argv[]) {
+    std::map<std::string, std::string> options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos) {
+            std::cout << "Usage: bench [--min-time=ms] [--filter=texto] [--tilesets=Roads,Carcassonne] [--sizes=16,32]\n";
+            return 1;
+        }
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+
+    double min_time_ms = options.count("min-time") ? std::stod(options["min-time"]) : 200.0;
+    std::string filter = options.count("filter") ? options["filter"] : "";
+    std::vector<std::string> tileset_names = parse_names(options.count("tilesets") ? options["tilesets"]
+                                                         : "Roads,Roads++,Carcassonne,Carcassonne++,Completo");
+
+    std::vector<Kernel> kernels = {
+        {"wfc.propagate", bench_wfc_propagate, {16, 32, 64}},
+        {"fp.collapse", bench_fp_collapse, {64, 256, 1024}},
+        {"nwfc.subgrid", bench_nwfc_subgrid, {4, 8, 16}},
+        {"image.generate", bench_generate_image, {16, 64}},
+    };
+    if (options.count("sizes"))
+        for (Kernel& kernel : kernels)
+            kernel.sizes = parse_list(options["sizes"]);
+
+    std::vector<LoadedTileset> tilesets(tileset_names.size());
+    for (size_t t = 0; t < tileset_names.size(); t++) {
+        tilesets[t].name = tileset_names[t];
+        if (SyntheticTileset::is_spec(tileset_names[t])) {
+            SyntheticTileset synthetic;
+            if (!synthetic.parse(tileset_names[t]))
+                return 1;
+            tilesets[t].name = synthetic.name();
+            tilesets[t].synthetic = true;
+            if (!synthetic.generate(tilesets[t].reader.constraints))
+                return 1;
+        } else {
+            tilesets[t].reader.read_files(tileset_names[t]);
+        }
+        tilesets[t].tileset.build(tilesets[t].reader.generate_domain());
+        tilesets[t].cell.domain.fill(tilesets[t].tileset.num_tiles);
+    }
+
+    // Solvers and the image writer report progress on stdout; results go to the original stream
+    std::ostream out(std::cout.rdbuf());
+    std::ostringstream discarded;
+    std::cout.rdbuf(discarded.rdbuf());
+
+    out << std::left << std::setw(16) << "kernel" << std::setw(15) << "tileset" << std::right
+        << std::setw(14) << "grid" << std::setw(12) << "iterations" << std::setw(12) << "ops"
+        << std::setw(16) << "ns/op" << std::setw(14) << "bytes/op" << std::setw(12) << "allocs/op" << std::setw(14) << "peak bytes" << "\n";
+
+    for (const Kernel& kernel : kernels) {
+        if (!filter.empty() && std::string(kernel.name).find(filter) == std::string::npos)
+            continue;
+        for (const LoadedTileset& ts : tilesets) {
+            if (kernel.run == bench_generate_image && ts.synthetic)
+                continue;
+            for (int size : kernel.sizes) {
+                // One untimed pass warms caches and the tile decoder, then iterate until min_time_ms
+                Measure warmup;
+                kernel.run(ts, size, 1, warmup);
+
+                Measure m;
+                auto begin = Clock::now();
+                unsigned int seed = 1;
+                do {
+                    kernel.run(ts, size, seed++, m);
+                    m.iterations++;
+                    discarded.str("");
+                } while (std::chrono::duration<double, std::milli>(Clock::now() - begin).count() < min_time_ms);
+
+                double ops = static_cast<double>(std::max<uint64_t>(m.ops, 1));
+                std::ostringstream label;
+                label << size << "x" << size;
+                out << std::left << std::setw(16) << kernel.name << std::setw(15) << ts.name << std::right
+                    << std::setw(14) << label.str() << std::setw(12) << m.iterations << std::setw(12) << m.ops
+                    << std::setw(16) << std::fixed << std::setprecision(1) << m.ns / ops
+                    << std::setw(14) << std::setprecision(1) << m.bytes / ops
+                    << std::setw(12) << std::setprecision(2) << m.allocs / ops
+                    << std::setw(14) << m.peak << "\n" << std::flush;
+            }
+        }
+    }
+
+    std::cout.rdbuf(out.rdbuf());
+    std::remove("bench_render.ppm");
+    return 0;
+}
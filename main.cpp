@@ -1,15 +1,26 @@
 #include "Reader.hpp"
 #include "Tile.hpp"
 #include "Cell.hpp"
-#include "FastPropagation.hpp"
-#include "ImageGenerator.hpp"
+#include "Tileset.hpp"
 #include "WFC.hpp"
-#include "NWFC.hpp"
+#include "ImageGenerator.hpp"
+#include "Atlas.hpp"
+#include "SyntheticTileset.hpp"
+#include "PerfCounters.hpp"
+#include "ThreadPool.hpp"
+#include "Runner.hpp"
+#include "Report.hpp"
 #include <chrono>
 #include <string>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <algorithm>
+#include <iterator>
+#include <memory>
 
 // Helper function to format memory size with appropriate units
 std::string format_memory_size(size_t bytes) {
@@ -27,16 +38,63 @@ std::string format_memory_size(size_t bytes) {
     }
 }
 
+// Per-run details, printed in run order whatever order the runs finished in
+void print_run(const RunResult& result) {
+    if (result.backtracking)
+        std::cout << "  Backtracks: " << result.backtracks << ", Stack memory: " << format_memory_size(result.backtrack_memory) << std::endl;
+
+    // Display memory usage for first run
+    if (result.run == 0) {
+        std::cout << "  " << (result.backtracking ? "Total memory usage (estimated): " : "Memory usage (estimated): ") << format_memory_size(result.memory) << std::endl;
+        std::cout << "  Heap: peak " << format_memory_size(result.peak_heap) << " (init " << format_memory_size(result.init_heap.peak_bytes)
+                  << ", run " << format_memory_size(result.run_heap.peak_bytes) << "), "
+                  << format_memory_size(result.init_heap.allocated_bytes + result.run_heap.allocated_bytes) << " in "
+                  << result.init_heap.allocations + result.run_heap.allocations << " allocations" << std::endl;
+        if (result.uncollapsed > 0)
+            std::cout << "  Uncollapsed cells: " << result.uncollapsed << std::endl;
+    }
+}
+
+// One phase of the --perf summary; per cell figures only for phases that work on cells
+void print_perf(const char* phase, const PerfSample& sample, size_t cells) {
+    std::ostringstream line;
+    line << "  " << std::left << std::setw(7) << phase << std::right << std::fixed
+         << " cycles " << sample.cycles << ", instructions " << sample.instructions
+         << ", IPC " << std::setprecision(2) << sample.ipc()
+         << ", cache misses " << sample.cache_misses << ", branch misses " << sample.branch_misses;
+    if (cells > 0)
+        line << std::setprecision(3) << " (" << static_cast<double>(sample.cache_misses) / cells << " / "
+             << static_cast<double>(sample.branch_misses) / cells << " per cell)";
+    std::cout << line.str() << "\n";
+}
+
 void print_usage(const char* program_name) {
     std::cout << "Argumentos:\n";
-    std::cout << "  algoritmo: FP, FP_BACKTRACK, FP_DIAGONAL, FP_DIAGONAL_BACKTRACK, WFC, WFC_BACKTRACK, WFC_DIAGONAL, WFC_DIAGONAL_BACKTRACK, NWFC, NWFC_BACKTRACK\n";
+    std::cout << "  algoritmo: FP, FP_TABLE, FP_STREAM, FP_BACKTRACK, FP_DIAGONAL, FP_DIAGONAL_PARALLEL, FP_DIAGONAL_BACKTRACK, WFC, WFC_BACKTRACK, WFC_DIAGONAL, WFC_DIAGONAL_BACKTRACK, NWFC, NWFC_BACKTRACK, NWFC_PARALLEL, NWFC_PARALLEL_BACKTRACK\n";
     std::cout << "  pasta: Tilesets -> Roads, Raods--, Roads++, Carcassonne, Carcassonne++\n";
+    std::cout << "         ou um atlas gerado pelo pack_atlas (ex.: Carcassonne.atlas)\n";
+    std::cout << "         ou um conjunto sintetico em memoria: synthetic:tiles=2000:labels=16:skew=1:hardness=0.2:seed=1\n";
     std::cout << "  grid_size: Size of the grid (e.g., 10 for 10x10)\n";
     std::cout << "  seed: Random seed (integer)\n";
     std::cout << "  gerar_imagem: 1 gera iamgem, 0 nao gera\n";
     std::cout << "  num_runs: number of times to run the algorithm\n";
     std::cout << "  subgrid_size: necessário se for usar o NWFC onde o tamanho_subgrid >= 2\n";
-    std::cout << "Usage: main <algoritmo> <pasta> <tamanho_matriz> <seed> <gerar_imagem> <num_runs> [tamanho_subgrid]\n";
+    std::cout << "Opcoes:\n";
+    std::cout << "  --propagation=AC3|AC4|LABEL: propagacao usada pelo WFC e NWFC (padrao AC3)\n";
+    std::cout << "  --threads=N: threads dos modos paralelos e da composicao da imagem, 0 usa todos os nucleos (padrao 0)\n";
+    std::cout << "  --rows=N: linhas do FP_STREAM (padrao tamanho_matriz)\n";
+    std::cout << "  --output=arquivo: FP_STREAM grava os ids (int32, linha a linha) no arquivo\n";
+    std::cout << "  --format=json|csv: grava um registro por execucao e um resumo (min/mediana/p95/max)\n";
+    std::cout << "  --report=arquivo: destino do --format (padrao <algoritmo>_<pasta>_<tamanho>_<seed>.json|csv)\n";
+    std::cout << "  --warmup=N: N execucoes nao medidas antes das medidas\n";
+    std::cout << "  --pin: fixa a thread principal e as do --batch em CPUs\n";
+    std::cout << "  --perf: contadores de hardware (ciclos, instrucoes, cache e branch misses) por fase (Linux)\n";
+    std::cout << "  --baseline=arquivo.json: compara o tempo de execucao com um relatorio --format=json (teste t de Welch)\n";
+    std::cout << "  --alpha=A: nivel de significancia do --baseline (padrao 0.05)\n";
+    std::cout << "  --min-change=P: menor mudanca, em %, que o --baseline acusa (padrao 3)\n";
+    std::cout << "  --batch=N: executa as sementes em paralelo em N threads, 0 usa todos os nucleos (padrao: em sequencia)\n";
+    std::cout << "Usage: main <algoritmo> <pasta> <tamanho_matriz> <seed> <gerar_imagem> <num_runs> [tamanho_subgrid] [--opcao=valor ...]\n";
+    std::cout << "       main SWEEP <seed> <num_runs> --algorithms=A,B --tilesets=P,Q --sizes=N,M [--subgrids=S,T] [--opcao=valor ...]\n";
     std::cout << "Exemplos:\n";
     std::cout << "main WFC Roads 10 1234 1 5\n";
     std::cout << "main WFC_BACKTRACK Roads 10 1234 1 3\n";
@@ -46,373 +104,438 @@ void print_usage(const char* program_name) {
     std::cout << "main FP_DIAGONAL_BACKTRACK Roads 10 1234 1 3\n";
     std::cout << "main NWFC Assets 20 5678 0 10 3\n";
     std::cout << "main NWFC_BACKTRACK Assets 20 5678 0 10 3\n";
+    std::cout << "main NWFC_PARALLEL_BACKTRACK Carcassonne 40 5678 0 3 5 --threads=4\n";
     std::cout << "main FP_DIAGONAL Roads++ 15 9999 1 3\n";
+    std::cout << "main FP_TABLE Carcassonne 1000 1234 0 5\n";
+    std::cout << "main FP_STREAM Roads 4096 1234 0 1 --rows=1000000 --output=mapa.bin\n";
+    std::cout << "main FP_DIAGONAL_PARALLEL Carcassonne 4000 1234 0 5 --threads=8\n";
+    std::cout << "main WFC_DIAGONAL Carcassonne 30 1234 0 5 --propagation=AC4\n";
+    std::cout << "main FP Carcassonne.atlas 100 1234 1 20\n";
+    std::cout << "main WFC synthetic:tiles=2000:labels=16:hardness=0.2 32 1234 0 5\n";
+    std::cout << "main WFC_BACKTRACK Carcassonne 30 1234 0 64 --batch=0\n";
+    std::cout << "main FP_TABLE Carcassonne 2000 1234 0 20 --format=json --report=fp_table.json\n";
+    std::cout << "main FP_TABLE Carcassonne 2000 1234 0 30 --warmup=3 --pin --baseline=fp_table.json\n";
+    std::cout << "main WFC Carcassonne 64 1234 1 10 --perf\n";
+    std::cout << "main SWEEP 1234 5 --algorithms=WFC,WFC_BACKTRACK,NWFC --tilesets=Roads,Carcassonne --sizes=16,32,64 --subgrids=3,5\n";
+}
+
+static const char* ALGORITHMS[] = {
+    "FP", "FP_TABLE", "FP_STREAM", "FP_BACKTRACK", "FP_DIAGONAL", "FP_DIAGONAL_PARALLEL", "FP_DIAGONAL_BACKTRACK",
+    "WFC", "WFC_BACKTRACK", "WFC_DIAGONAL", "WFC_DIAGONAL_BACKTRACK",
+    "NWFC", "NWFC_BACKTRACK", "NWFC_PARALLEL", "NWFC_PARALLEL_BACKTRACK"};
+
+static bool is_known_algorithm(const std::string& algorithm) {
+    return std::find(std::begin(ALGORITHMS), std::end(ALGORITHMS), algorithm) != std::end(ALGORITHMS);
+}
+
+static bool is_atlas(const std::string& folder) {
+    return folder.size() > 6 && folder.compare(folder.size() - 6, 6, ".atlas") == 0;
+}
+
+// Name used for output files and reports: the folder, the atlas without ".atlas" or the synthetic
+// spec, empty when the spec is invalid
+static std::string tileset_label(const std::string& folder) {
+    SyntheticTileset synthetic;
+    if (SyntheticTileset::is_spec(folder))
+        return synthetic.parse(folder) ? synthetic.name() : "";
+    return is_atlas(folder) ? folder.substr(0, folder.size() - 6) : folder;
+}
+
+// Reads a tileset folder, packed atlas or synthetic spec into the constraint table and the full starting cell
+static bool load_tileset(const std::string& folder, Reader& r, Atlas& atlas, Tileset& tileset, Cell& c) {
+    if (SyntheticTileset::is_spec(folder)) {
+        SyntheticTileset synthetic;
+        if (!synthetic.parse(folder))
+            return false;
+        if (!synthetic.generate(r.constraints))
+            return false;
+    } else if (is_atlas(folder)) {
+        if (!atlas.open(folder))
+            return false;
+        r.constraints = atlas.constraints;
+    } else {
+        r.read_files(folder);
+    }
+    tileset.build(r.generate_domain());
+    c.domain.fill(tileset.num_tiles);
+    return true;
+}
+
+static std::vector<std::string> split_list(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+// Runs the cross product of algorithms x tilesets x grid sizes (x subgrid sizes for NWFC) in one
+// process, loading each tileset once, and prints throughput against grid size
+static int run_sweep(const std::vector<std::string>& args, std::map<std::string, std::string>& options, const char* program) {
+    if (args.size() < 4 || !options.count("algorithms") || !options.count("tilesets") || !options.count("sizes")) {
+        print_usage(program);
+        return 1;
+    }
+    unsigned int seed = static_cast<unsigned int>(std::stoi(args[2]));
+    int num_runs = std::stoi(args[3]);
+    std::vector<std::string> algorithms = split_list(options["algorithms"]);
+    std::vector<std::string> folders = split_list(options["tilesets"]);
+    std::vector<int> sizes, subgrids;
+    for (const std::string& item : split_list(options["sizes"]))
+        sizes.push_back(std::stoi(item));
+    for (const std::string& item : split_list(options.count("subgrids") ? options["subgrids"] : "3"))
+        subgrids.push_back(std::stoi(item));
+    std::sort(sizes.begin(), sizes.end());
+
+    int threads = options.count("threads") ? std::stoi(options["threads"]) : 0;
+    int batch_threads = options.count("batch") ? std::stoi(options["batch"]) : -1;
+    int warmup = options.count("warmup") ? std::stoi(options["warmup"]) : 0;
+    bool pin = options.count("pin") && options["pin"] != "0";
+    bool perf = options.count("perf") && options["perf"] != "0";
+    double alpha = options.count("alpha") ? std::stod(options["alpha"]) : 0.05;
+    double min_change = (options.count("min-change") ? std::stod(options["min-change"]) : 3.0) / 100.0;
+    std::string propagation = options.count("propagation") ? options["propagation"] : "AC3";
+    std::string format = options.count("format") ? options["format"] : "";
+    for (const std::string& algorithm : algorithms) {
+        if (!is_known_algorithm(algorithm)) {
+            std::cout << "Error: Unknown algorithm '" << algorithm << "'\n";
+            return 1;
+        }
+    }
+    if (propagation != "AC3" && propagation != "AC4" && propagation != "LABEL") {
+        std::cout << "Error: Unknown propagation '" << propagation << "'\n";
+        return 1;
+    }
+    if (!format.empty() && format != "json" && format != "csv") {
+        std::cout << "Error: Unknown format '" << format << "'\n";
+        return 1;
+    }
+    std::vector<BaselineRun> baseline;
+    if (options.count("baseline") && !load_baseline(options["baseline"], baseline))
+        return 1;
+
+    using Clock = std::chrono::high_resolution_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    if (pin && !ThreadPool::pin_current_thread(0))
+        std::cerr << "Warning: Could not pin threads to CPUs on this system" << std::endl;
+    std::unique_ptr<ThreadPool> pool;
+    if (batch_threads >= 0)
+        pool.reset(new ThreadPool(batch_threads, pin));
+
+    PerfCounters probe;
+    if (perf && !probe.open())
+        std::cerr << "Warning: Hardware counters unavailable (Linux perf_event_open, see /proc/sys/kernel/perf_event_paranoid)" << std::endl;
+
+    std::cout << "Sweep: " << algorithms.size() << " algorithms x " << folders.size() << " tilesets x "
+              << sizes.size() << " sizes, " << num_runs << " runs each (seed " << seed << ") [" << propagation << "]" << std::endl;
+    std::cout << std::left << std::setw(24) << "algorithm" << std::setw(15) << "tileset" << std::right
+              << std::setw(8) << "subgrid" << std::setw(12) << "grid" << std::setw(12) << "cells"
+              << std::setw(14) << "run ms" << std::setw(16) << "cells/s" << std::setw(12) << "ns/cell"
+              << std::setw(12) << "peak heap" << std::setw(10) << "scaling" << "\n";
+
+    std::vector<ReportGroup> groups;
+    bool regression = false;
+    for (const std::string& folder : folders) {
+        Reader r;
+        Atlas atlas;
+        Tileset tileset;
+        Cell c;
+        auto t_start = Clock::now();
+        if (!load_tileset(folder, r, atlas, tileset, c) || !WFC::supports_propagation(propagation, tileset))
+            return 1;
+        Milliseconds ms_read = Clock::now() - t_start;
+        std::string tileset_name = tileset_label(folder);
+
+        for (const std::string& algorithm : algorithms) {
+            bool nested = algorithm.rfind("NWFC", 0) == 0;
+            for (int subgrid : nested ? subgrids : std::vector<int>(1, 0)) {
+                double first_ns_per_cell = 0.0;
+                for (int size : sizes) {
+                    RunConfig config;
+                    config.algorithm = algorithm;
+                    config.grid_size = size;
+                    config.subgrid_size = nested ? subgrid : 2;
+                    config.stream_rows = size;
+                    config.threads = threads;
+                    config.propagation = propagation;
+                    config.cell = &c;
+                    config.tileset = &tileset;
+                    config.perf = perf;
+
+                    run_seeds(config, seed, warmup, pool.get());
+                    auto batch_start = Clock::now();
+                    ReportGroup group;
+                    group.results = run_seeds(config, seed, num_runs, pool.get());
+                    Milliseconds ms_batch = Clock::now() - batch_start;
+
+                    ReportInfo& info = group.info;
+                    info.algorithm = algorithm;
+                    info.tileset = tileset_name;
+                    info.propagation = propagation;
+                    info.rows = size;
+                    info.columns = size;
+                    info.subgrid_size = nested ? subgrid : 0;
+                    info.threads = threads;
+                    info.read_ms = ms_read.count();
+                    info.wall_ms = ms_batch.count();
+                    info.warmup = warmup;
+                    info.pinned = pin;
+
+                    // Medians are robust to the odd slow run; scaling is ns/cell against the smallest grid
+                    std::vector<double> run_times, rates, costs, heaps;
+                    for (const RunResult& result : group.results) {
+                        heaps.push_back(static_cast<double>(result.peak_heap));
+                        run_times.push_back(result.run_ms);
+                        rates.push_back(result.run_ms > 0.0 ? result.cells / (result.run_ms / 1000.0) : 0.0);
+                        costs.push_back(result.cells > 0 ? result.run_ms * 1e6 / result.cells : 0.0);
+                    }
+                    double ns_per_cell = summarize(costs).median;
+                    if (first_ns_per_cell == 0.0)
+                        first_ns_per_cell = ns_per_cell;
+                    group.scaling = first_ns_per_cell > 0.0 ? ns_per_cell / first_ns_per_cell : 0.0;
+                    size_t cells = group.results.empty() ? 0 : group.results[0].cells;
+
+                    std::ostringstream grid;
+                    grid << size << "x" << size;
+                    std::cout << std::left << std::setw(24) << algorithm << std::setw(15) << tileset_name << std::right
+                              << std::setw(8) << (nested ? std::to_string(subgrid) : "-") << std::setw(12) << grid.str()
+                              << std::setw(12) << cells << std::fixed << std::setprecision(3)
+                              << std::setw(14) << summarize(run_times).median << std::setprecision(0)
+                              << std::setw(16) << summarize(rates).median << std::setprecision(1)
+                              << std::setw(12) << ns_per_cell
+                              << std::setw(12) << format_memory_size(static_cast<size_t>(summarize(heaps).median)) << std::setprecision(2)
+                              << std::setw(9) << group.scaling << "x";
+
+                    if (!baseline.empty()) {
+                        Comparison cmp = compare_with_baseline(baseline, info, group.results, alpha, min_change);
+                        if (cmp.baseline_samples > 0)
+                            std::cout << "  " << std::showpos << cmp.change * 100.0 << "% [" << cmp.change_low * 100.0 << "%, "
+                                      << cmp.change_high * 100.0 << "%]" << std::noshowpos << " vs baseline";
+                        if (cmp.significant && cmp.change > 0.0) {
+                            std::cout << " REGRESSION (p = " << std::defaultfloat << std::setprecision(4) << cmp.p_value << ")";
+                            regression = true;
+                        }
+                    }
+                    std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+                    groups.push_back(group);
+                }
+            }
+        }
+    }
+
+    if (!format.empty()) {
+        std::string report_file = options.count("report") ? options["report"] : "sweep_" + std::to_string(seed) + "." + format;
+        if (!write_sweep_report(report_file, format, groups))
+            return 1;
+        std::cout << "Report saved to: " << report_file << std::endl;
+    }
+    return regression ? 2 : 0;
 }
 
 int main(int argc, char const *argv[])
 {
-    if (argc < 7) {
+    // Split positional arguments from --name=value options
+    std::vector<std::string> args;
+    std::map<std::string, std::string> options;
+    for (int i = 0; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i > 0 && arg.rfind("--", 0) == 0) {
+            size_t eq = arg.find('=');
+            if (eq == std::string::npos)
+                options[arg.substr(2)] = "1";
+            else
+                options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.size() >= 2 && args[1] == "SWEEP")
+        return run_sweep(args, options, argv[0]);
+
+    if (args.size() < 7) {
         print_usage(argv[0]);
         return 1;
     }
 
     // Parse command line arguments
-    std::string algorithm = argv[1];
-    std::string folder = argv[2];
-    int grid_size = std::stoi(argv[3]);
-    int seed = std::stoi(argv[4]);
-    bool generate_image = (std::stoi(argv[5]) == 1);
-    int num_runs = std::stoi(argv[6]);
+    std::string algorithm = args[1];
+    std::string folder = args[2];
+    // A packed atlas (see pack_atlas) replaces the tileset folder; outputs keep the tileset name
+    bool use_atlas = is_atlas(folder);
+    std::string tileset_name = tileset_label(folder);
+    if (tileset_name.empty())
+        return 1;
+    int grid_size = std::stoi(args[3]);
+    int seed = std::stoi(args[4]);
+    bool generate_image = (std::stoi(args[5]) == 1);
+    if (generate_image && SyntheticTileset::is_spec(folder)) {
+        std::cout << "Warning: Synthetic tilesets have no tile images (write them with tilegen), image disabled\n";
+        generate_image = false;
+    }
+    int num_runs = std::stoi(args[6]);
     int subgrid_size = 2; // default
     
-    if (algorithm == "NWFC" || algorithm == "NWFC_BACKTRACK") {
-        if (argc < 8) {
-            std::cout << "Error: NWFC and NWFC_BACKTRACK require subgrid_size parameter\n";
+    if (algorithm.rfind("NWFC", 0) == 0) {
+        if (args.size() < 8) {
+            std::cout << "Error: NWFC variants require subgrid_size parameter\n";
             print_usage(argv[0]);
             return 1;
         }
-        subgrid_size = std::stoi(argv[7]);
+        subgrid_size = std::stoi(args[7]);
+    }
+
+    int threads = options.count("threads") ? std::stoi(options["threads"]) : 0;
+    int batch_threads = options.count("batch") ? std::stoi(options["batch"]) : -1; // < 0 runs serially
+    int warmup = options.count("warmup") ? std::stoi(options["warmup"]) : 0;
+    bool pin = options.count("pin") && options["pin"] != "0";
+    bool perf = options.count("perf") && options["perf"] != "0";
+    double alpha = options.count("alpha") ? std::stod(options["alpha"]) : 0.05;
+    double min_change = (options.count("min-change") ? std::stod(options["min-change"]) : 3.0) / 100.0;
+    std::vector<BaselineRun> baseline;
+    if (options.count("baseline") && !load_baseline(options["baseline"], baseline))
+        return 1;
+    int stream_rows = options.count("rows") ? std::stoi(options["rows"]) : grid_size;
+
+    std::string format = options.count("format") ? options["format"] : "";
+    if (!format.empty() && format != "json" && format != "csv") {
+        std::cout << "Error: Unknown format '" << format << "'\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::string propagation = options.count("propagation") ? options["propagation"] : "AC3";
+    if (propagation != "AC3" && propagation != "AC4" && propagation != "LABEL") {
+        std::cout << "Error: Unknown propagation '" << propagation << "'\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (!is_known_algorithm(algorithm)) {
+        std::cout << "Error: Unknown algorithm '" << algorithm << "'\n";
+        print_usage(argv[0]);
+        return 1;
     }
 
     // Fixed parameters
-    std::string output_file = algorithm + "_" + folder + "_" + std::to_string(grid_size) + "_" + std::to_string(seed) + ".png";
+    std::string output_file = algorithm + "_" + tileset_name + "_" + std::to_string(grid_size) + "_" + std::to_string(seed) + ".png";
 
     std::cout << "Running " << algorithm << " on " << grid_size << "x" << grid_size 
               << " grid with tileset '" << folder << "' and seed " << seed << " for " << num_runs << " runs";
-    if (algorithm == "NWFC" || algorithm == "NWFC_BACKTRACK") {
+    if (algorithm.rfind("NWFC", 0) == 0) {
         std::cout << " (subgrid_size=" << subgrid_size << ")";
     }
+    if (algorithm.rfind("WFC", 0) == 0 || algorithm.rfind("NWFC", 0) == 0) {
+        std::cout << " [" << propagation << "]";
+    }
     std::cout << std::endl;
 
     Reader r;
     Cell c;
+    Tileset tileset;
     ImageGenerator ig;
+    Atlas atlas;
 
     // Chrono
     using Clock = std::chrono::high_resolution_clock;
     using Milliseconds = std::chrono::duration<double, std::milli>;
 
     // Read constraints
+    PerfCounters read_counters;
+    if (perf && !read_counters.open())
+        std::cerr << "Warning: Hardware counters unavailable (Linux perf_event_open, see /proc/sys/kernel/perf_event_paranoid)" << std::endl;
+    read_counters.start();
     auto t_start = Clock::now();
-    r.read_files(folder);
-    c.domain = r.generate_domain();
+    if (!load_tileset(folder, r, atlas, tileset, c))
+        return 1;
     auto t_end = Clock::now();
+    if (!WFC::supports_propagation(propagation, tileset))
+        return 1;
+    PerfSample read_perf = read_counters.stop();
     Milliseconds ms_read = t_end - t_start;
 
+    RunConfig config;
+    config.algorithm = algorithm;
+    config.grid_size = grid_size;
+    config.subgrid_size = subgrid_size;
+    config.stream_rows = stream_rows;
+    config.threads = threads;
+    config.propagation = propagation;
+    config.cell = &c;
+    config.tileset = &tileset;
+    config.perf = perf;
+
+    // Only the first run renders the image and writes the FP_STREAM ids
+    RunOutput first_output;
+    if (generate_image) {
+        if (use_atlas)
+            ig.initialize(atlas);
+        else
+            ig.initialize(r, folder);
+        ig.set_threads(threads);
+        first_output.image = &ig;
+        first_output.image_file = output_file;
+    }
+    if (algorithm == "FP_STREAM" && options.count("output")) {
+        first_output.ids = std::fopen(options["output"].c_str(), "wb");
+        if (!first_output.ids)
+            std::cerr << "Error: Could not open " << options["output"] << " for writing" << std::endl;
+    }
+
+    // The main thread takes part in every run (and every batch) and is pinned to CPU 0,
+    // batch workers to CPUs 1, 2, ...
+    if (pin && !ThreadPool::pin_current_thread(0))
+        std::cerr << "Warning: Could not pin threads to CPUs on this system" << std::endl;
+    std::unique_ptr<ThreadPool> pool;
+    if (batch_threads >= 0)
+        pool.reset(new ThreadPool(batch_threads, pin));
+
+    // Unmeasured runs with the same seeds warm caches, the allocator and the CPU clock
+    if (warmup > 0) {
+        std::cout << "Warmup: " << warmup << " runs..." << std::endl;
+        run_seeds(config, seed, warmup, pool.get());
+    }
+
+    // Run the algorithm multiple times, seed + run for each run
+    std::vector<RunResult> results(num_runs);
+    auto batch_start = Clock::now();
+    if (!pool) {
+        // Same per run bookkeeping (peak RSS reset) as the batch path, progress printed as it goes
+        results = run_seeds(config, seed, num_runs, nullptr, first_output, [&](int run, const RunResult* result) {
+            if (!result)
+                std::cout << "Run " << (run + 1) << "/" << num_runs << "..." << std::endl;
+            else
+                print_run(*result);
+        });
+    } else {
+        // Independent seeds run concurrently; details are printed afterwards in run order
+        std::cout << "Batch: " << num_runs << " runs on " << pool->size() << " threads..." << std::endl;
+        results = run_seeds(config, seed, num_runs, pool.get(), first_output);
+        for (int run = 0; run < num_runs; run++) {
+            std::cout << "Run " << (run + 1) << "/" << num_runs << " (seed " << results[run].seed << "): init "
+                      << results[run].init_ms << " ms, run " << results[run].run_ms << " ms, total " << results[run].total_ms << " ms" << std::endl;
+            print_run(results[run]);
+        }
+    }
+    Milliseconds ms_batch = Clock::now() - batch_start;
+    if (first_output.ids)
+        std::fclose(first_output.ids);
+
     // Variables to accumulate times
     double total_init_time = 0.0;
     double total_run_time = 0.0;
     double total_execution_time = 0.0;
     int total_backtracks = 0;
     size_t total_backtrack_memory_cost = 0;
-
-    // Run the algorithm multiple times
-    for (int run = 0; run < num_runs; run++) {
-        std::cout << "Run " << (run + 1) << "/" << num_runs << "..." << std::endl;
-        
-        // Initialize and run algorithm
-        t_start = Clock::now();
-        auto init_start = Clock::now();
-        
-        if (algorithm == "FP") {
-            FastPropagation fp;
-            fp.initialize_fp(grid_size, grid_size, c, seed + run); // Use different seed for each run
-            auto init_end = Clock::now();
-            Milliseconds ms_init = init_end - init_start;
-            
-            auto run_start = Clock::now();
-            fp.run("FP");
-            auto run_end = Clock::now();
-            Milliseconds ms_run = run_end - run_start;
-            
-            total_init_time += ms_init.count();
-            total_run_time += ms_run.count();
-            
-            // Display memory usage for first run
-            if (run == 0) {
-                size_t memory_total = fp.get_memory_usage();
-                std::cout << "  Memory usage: " << format_memory_size(memory_total) << std::endl;
-            }
-            
-            if (generate_image && run == 0) { // Only generate image for first run
-                ig.initialize(r, folder);
-                ig.generate_image(fp.matrix, output_file);
-            }
-        }
-        else if (algorithm == "FP_BACKTRACK") {
-            FastPropagation fp;
-            fp.initialize_fp(grid_size, grid_size, c, seed + run);
-            auto init_end = Clock::now();
-            Milliseconds ms_init = init_end - init_start;
-            
-            auto run_start = Clock::now();
-            fp.FP(true); // Enable backtracking
-            auto run_end = Clock::now();
-            Milliseconds ms_run = run_end - run_start;
-            
-            total_init_time += ms_init.count();
-            total_run_time += ms_run.count();
-            
-            int run_backtracks = fp.get_backtrack_count();
-            size_t run_backtrack_memory = fp.get_backtrack_stack_memory_usage(); // Use current stack size instead of cumulative cost
-            
-            total_backtracks += run_backtracks;
-            total_backtrack_memory_cost += run_backtrack_memory;
-            
-            std::cout << "  Backtracks: " << run_backtracks << ", Stack memory: " << format_memory_size(run_backtrack_memory) << std::endl;
-            
-            // Display memory usage for first run
-            if (run == 0) {
-                size_t memory_total = fp.get_memory_usage();
-                std::cout << "  Total memory usage: " << format_memory_size(memory_total) << std::endl;
-            }
-            
-            if (generate_image && run == 0) {
-                ig.initialize(r, folder);
-                ig.generate_image(fp.matrix, output_file);
-            }
-        }
-        else if (algorithm == "FP_DIAGONAL") {
-            FastPropagation fp;
-            fp.initialize_fp(grid_size, grid_size, c, seed + run);
-            auto init_end = Clock::now();
-            Milliseconds ms_init = init_end - init_start;
-            
-            auto run_start = Clock::now();
-            fp.run("Diagonal");
-            auto run_end = Clock::now();
-            Milliseconds ms_run = run_end - run_start;
-            
-            total_init_time += ms_init.count();
-            total_run_time += ms_run.count();
-            
-            // Display memory usage for first run
-            if (run == 0) {
-                size_t memory_total = fp.get_memory_usage();
-                std::cout << "  Memory usage: " << format_memory_size(memory_total) << std::endl;
-            }
-            
-            if (generate_image && run == 0) {
-                ig.initialize(r, folder);
-                ig.generate_image(fp.matrix, output_file);
-            }
-        }
-        else if (algorithm == "FP_DIAGONAL_BACKTRACK") {
-            FastPropagation fp;
-            fp.initialize_fp(grid_size, grid_size, c, seed + run);
-            auto init_end = Clock::now();
-            Milliseconds ms_init = init_end - init_start;
-            
-            auto run_start = Clock::now();
-            fp.Diag(true); // Enable backtracking for diagonal
-            auto run_end = Clock::now();
-            Milliseconds ms_run = run_end - run_start;
-            
-            total_init_time += ms_init.count();
-            total_run_time += ms_run.count();
-            
-            int run_backtracks = fp.get_backtrack_count();
-            size_t run_backtrack_memory = fp.get_backtrack_stack_memory_usage(); // Use current stack size instead of cumulative cost
-            
-            total_backtracks += run_backtracks;
-            total_backtrack_memory_cost += run_backtrack_memory;
-            
-            std::cout << "  Backtracks: " << run_backtracks << ", Stack memory: " << format_memory_size(run_backtrack_memory) << std::endl;
-            
-            // Display memory usage for first run
-            if (run == 0) {
-                size_t memory_total = fp.get_memory_usage();
-                std::cout << "  Total memory usage: " << format_memory_size(memory_total) << std::endl;
-            }
-            
-            if (generate_image && run == 0) {
-                ig.initialize(r, folder);
-                ig.generate_image(fp.matrix, output_file);
-            }
-        }
-        else if (algorithm == "WFC") {
-            WFC wfc;
-            wfc.initialize_wfc(grid_size, grid_size, c, seed + run);
-            auto init_end = Clock::now();
-            Milliseconds ms_init = init_end - init_start;
-            
-            auto run_start = Clock::now();
-            wfc.run("MRV");
-            auto run_end = Clock::now();
-            Milliseconds ms_run = run_end - run_start;
-            
-            total_init_time += ms_init.count();
-            total_run_time += ms_run.count();
-            
-            // Display memory usage for first run
-            if (run == 0) {
-                size_t memory_total = wfc.get_memory_usage();
-                std::cout << "  Memory usage: " << format_memory_size(memory_total) << std::endl;
-            }
-            
-            if (generate_image && run == 0) {
-                ig.initialize(r, folder);
-                ig.generate_image(wfc.matrix, output_file);
-            }
-        }
-        else if (algorithm == "WFC_BACKTRACK") {
-            WFC wfc;
-            wfc.initialize_wfc(grid_size, grid_size, c, seed + run);
-            auto init_end = Clock::now();
-            Milliseconds ms_init = init_end - init_start;
-            
-            auto run_start = Clock::now();
-            wfc.MRV(true); // Enable backtracking
-            auto run_end = Clock::now();
-            Milliseconds ms_run = run_end - run_start;
-            
-            total_init_time += ms_init.count();
-            total_run_time += ms_run.count();
-            
-            int run_backtracks = wfc.get_backtrack_count();
-            size_t run_backtrack_memory = wfc.get_backtrack_stack_memory_usage();
-            
-            total_backtracks += run_backtracks;
-            total_backtrack_memory_cost += run_backtrack_memory;
-            
-            std::cout << "  Backtracks: " << run_backtracks << ", Stack memory: " << format_memory_size(run_backtrack_memory) << std::endl;
-            
-            // Display memory usage for first run
-            if (run == 0) {
-                size_t memory_total = wfc.get_memory_usage();
-                std::cout << "  Total memory usage: " << format_memory_size(memory_total) << std::endl;
-            }
-            
-            if (generate_image && run == 0) {
-                ig.initialize(r, folder);
-                ig.generate_image(wfc.matrix, output_file);
-            }
-        }
-        else if (algorithm == "WFC_DIAGONAL") {
-            WFC wfc;
-            wfc.initialize_wfc(grid_size, grid_size, c, seed + run);
-            auto init_end = Clock::now();
-            Milliseconds ms_init = init_end - init_start;
-            
-            auto run_start = Clock::now();
-            wfc.run("Diagonal");
-            auto run_end = Clock::now();
-            Milliseconds ms_run = run_end - run_start;
-            
-            total_init_time += ms_init.count();
-            total_run_time += ms_run.count();
-            
-            // Display memory usage for first run
-            if (run == 0) {
-                size_t memory_total = wfc.get_memory_usage();
-                std::cout << "  Memory usage: " << format_memory_size(memory_total) << std::endl;
-            }
-            
-            if (generate_image && run == 0) {
-                ig.initialize(r, folder);
-                ig.generate_image(wfc.matrix, output_file);
-            }
-        }
-        else if (algorithm == "WFC_DIAGONAL_BACKTRACK") {
-            WFC wfc;
-            wfc.initialize_wfc(grid_size, grid_size, c, seed + run);
-            auto init_end = Clock::now();
-            Milliseconds ms_init = init_end - init_start;
-            
-            auto run_start = Clock::now();
-            wfc.Diag(true); // Enable backtracking for diagonal
-            auto run_end = Clock::now();
-            Milliseconds ms_run = run_end - run_start;
-            
-            total_init_time += ms_init.count();
-            total_run_time += ms_run.count();
-            
-            int run_backtracks = wfc.get_backtrack_count();
-            size_t run_backtrack_memory = wfc.get_backtrack_stack_memory_usage();
-            
-            total_backtracks += run_backtracks;
-            total_backtrack_memory_cost += run_backtrack_memory;
-            
-            std::cout << "  Backtracks: " << run_backtracks << ", Stack memory: " << format_memory_size(run_backtrack_memory) << std::endl;
-            
-            // Display memory usage for first run
-            if (run == 0) {
-                size_t memory_total = wfc.get_memory_usage();
-                std::cout << "  Total memory usage: " << format_memory_size(memory_total) << std::endl;
-            }
-            
-            if (generate_image && run == 0) {
-                ig.initialize(r, folder);
-                ig.generate_image(wfc.matrix, output_file);
-            }
-        }
-        else if (algorithm == "NWFC") {
-            NWFC nwfc;
-            nwfc.initialize_nwfc(grid_size, grid_size, subgrid_size, c, seed + run);
-            auto init_end = Clock::now();
-            Milliseconds ms_init = init_end - init_start;
-            
-            auto run_start = Clock::now();
-            nwfc.run();
-            auto run_end = Clock::now();
-            Milliseconds ms_run = run_end - run_start;
-            
-            total_init_time += ms_init.count();
-            total_run_time += ms_run.count();
-            
-            // Display memory usage for first run
-            if (run == 0) {
-                size_t memory_total = nwfc.get_memory_usage();
-                std::cout << "  Memory usage: " << format_memory_size(memory_total) << std::endl;
-            }
-            
-            if (generate_image && run == 0) {
-                ig.initialize(r, folder);
-                ig.generate_image(nwfc.matrix, output_file);
-            }
-        }
-        else if (algorithm == "NWFC_BACKTRACK") {
-            NWFC nwfc;
-            nwfc.initialize_nwfc(grid_size, grid_size, subgrid_size, c, seed + run);
-            auto init_end = Clock::now();
-            Milliseconds ms_init = init_end - init_start;
-            
-            auto run_start = Clock::now();
-            nwfc.run(true); // Enable backtracking
-            auto run_end = Clock::now();
-            Milliseconds ms_run = run_end - run_start;
-            
-            total_init_time += ms_init.count();
-            total_run_time += ms_run.count();
-            
-            int run_backtracks = nwfc.get_total_backtrack_count();
-            size_t run_backtrack_memory = nwfc.get_total_backtrack_stack_memory_usage();
-            
-            total_backtracks += run_backtracks;
-            total_backtrack_memory_cost += run_backtrack_memory;
-            
-            std::cout << "  Backtracks: " << run_backtracks << ", Stack memory: " << format_memory_size(run_backtrack_memory) << std::endl;
-            
-            // Display memory usage for first run
-            if (run == 0) {
-                size_t memory_total = nwfc.get_memory_usage();
-                std::cout << "  Total memory usage: " << format_memory_size(memory_total) << std::endl;
-            }
-            
-            if (generate_image && run == 0) {
-                ig.initialize(r, folder);
-                ig.generate_image(nwfc.matrix, output_file);
-            }
-        }
-        else {
-            std::cout << "Error: Unknown algorithm '" << algorithm << "'\n";
-            print_usage(argv[0]);
-            return 1;
-        }
-        
-        t_end = Clock::now();
-        Milliseconds ms_total = t_end - t_start;
-        total_execution_time += ms_total.count();
+    for (const RunResult& result : results) {
+        total_init_time += result.init_ms;
+        total_run_time += result.run_ms;
+        total_execution_time += result.total_ms;
+        total_backtracks += result.backtracks;
+        total_backtrack_memory_cost += result.backtrack_memory;
     }
     
     // Calculate averages
@@ -429,11 +552,40 @@ int main(int argc, char const *argv[])
     std::cout << "Total init time: " << total_init_time << " ms\n";
     std::cout << "Total run time: " << total_run_time << " ms\n";
     std::cout << "Total execution time: " << total_execution_time << " ms\n";
+    if (batch_threads >= 0) {
+        std::cout << "Batch wall time: " << ms_batch.count() << " ms\n";
+    }
+    if (num_runs > 1) {
+        std::vector<double> run_times, total_times;
+        for (const RunResult& result : results) {
+            run_times.push_back(result.run_ms);
+            total_times.push_back(result.total_ms);
+        }
+        Interval run_ci = confidence_interval(run_times);
+        Interval total_ci = confidence_interval(total_times);
+        std::cout << "Run time 95% CI: [" << run_ci.low << ", " << run_ci.high << "] ms (mean " << run_ci.mean
+                  << ", outliers dropped: " << run_ci.outliers << ")\n";
+        std::cout << "Total time 95% CI: [" << total_ci.low << ", " << total_ci.high << "] ms (mean " << total_ci.mean
+                  << ", outliers dropped: " << total_ci.outliers << ")\n";
+    }
     
+    // Measured memory: heap from the counting operator new, RSS from the OS (process wide)
+    uint64_t max_peak_heap = 0, total_allocated = 0, total_allocations = 0;
+    size_t max_peak_rss = 0;
+    for (const RunResult& result : results) {
+        max_peak_heap = std::max(max_peak_heap, result.peak_heap);
+        total_allocated += result.init_heap.allocated_bytes + result.run_heap.allocated_bytes;
+        total_allocations += result.init_heap.allocations + result.run_heap.allocations;
+        max_peak_rss = std::max(max_peak_rss, result.peak_rss);
+    }
+    std::cout << "Peak heap per run: " << format_memory_size(max_peak_heap) << "\n";
+    std::cout << "Average heap allocated per run: " << format_memory_size(total_allocated / num_runs)
+              << " in " << total_allocations / num_runs << " allocations\n";
+    if (max_peak_rss > 0)
+        std::cout << "Peak RSS: " << format_memory_size(max_peak_rss) << "\n";
+
     // Display backtrack statistics for backtracking algorithms
-    if (algorithm == "FP_BACKTRACK" || algorithm == "FP_DIAGONAL_BACKTRACK" || 
-        algorithm == "WFC_BACKTRACK" || algorithm == "WFC_DIAGONAL_BACKTRACK" ||
-        algorithm == "NWFC_BACKTRACK") {
+    if (is_backtracking(algorithm)) {
         double avg_backtracks = static_cast<double>(total_backtracks) / num_runs;
         double avg_backtrack_memory = static_cast<double>(total_backtrack_memory_cost) / num_runs;
         
@@ -444,9 +596,80 @@ int main(int argc, char const *argv[])
         std::cout << "Average backtrack stack memory per run: " << format_memory_size(static_cast<size_t>(avg_backtrack_memory)) << "\n";
     }
     
+    bool counted = read_counters.is_open();
+    for (const RunResult& result : results)
+        counted = counted || result.perf;
+    if (counted) {
+        PerfSample init_perf = {}, run_perf = {};
+        size_t total_cells = 0;
+        for (const RunResult& result : results) {
+            init_perf += result.init_perf;
+            run_perf += result.run_perf;
+            total_cells += result.cells;
+        }
+        std::cout << "=== PERFORMANCE COUNTERS (user space, all runs) ===\n";
+        print_perf("read", read_perf, 0);
+        print_perf("init", init_perf, total_cells);
+        print_perf("run", run_perf, total_cells);
+        if (generate_image)
+            print_perf("render", results[0].render_perf, results[0].cells);
+    }
+
     if (generate_image) {
         std::cout << "Image saved to: " << output_file << " (from first run)" << std::endl;
     }
 
+    ReportInfo info;
+    info.algorithm = algorithm;
+    info.tileset = tileset_name;
+    info.propagation = propagation;
+    info.rows = algorithm == "FP_STREAM" ? stream_rows : grid_size;
+    info.columns = grid_size;
+    info.subgrid_size = algorithm.rfind("NWFC", 0) == 0 ? subgrid_size : 0;
+    info.threads = threads;
+    info.read_ms = ms_read.count();
+    info.wall_ms = ms_batch.count();
+    info.warmup = warmup;
+    info.pinned = pin;
+
+    // Machine-readable records, one per run plus the summary
+    if (!format.empty()) {
+        std::string report_file = options.count("report") ? options["report"]
+            : output_file.substr(0, output_file.size() - 4) + "." + format;
+        if (!write_report(report_file, format, info, results))
+            return 1;
+        std::cout << "Report saved to: " << report_file << std::endl;
+    }
+
+    // Flags run time changes against the baseline that are unlikely to be noise
+    if (options.count("baseline")) {
+        Comparison cmp = compare_with_baseline(baseline, info, results, alpha, min_change);
+        std::cout << "=== BASELINE COMPARISON ===\n";
+        if (cmp.baseline_samples == 0) {
+            std::cout << "No baseline runs for " << algorithm << " on " << tileset_name << " ("
+                      << info.rows << "x" << info.columns << ")\n";
+        } else {
+            std::cout << std::defaultfloat << std::setprecision(6);
+            std::cout << "Baseline run time: " << cmp.baseline_mean << " ms (n=" << cmp.baseline_samples << ")\n";
+            std::cout << "Current run time: " << cmp.current_mean << " ms (n=" << cmp.current_samples << ")\n";
+            std::cout << "Change: " << std::showpos << std::fixed << std::setprecision(2) << cmp.change * 100.0
+                      << "% (" << std::noshowpos << std::defaultfloat << (1.0 - alpha) * 100.0 << "% CI "
+                      << std::showpos << std::fixed << std::setprecision(2) << cmp.change_low * 100.0
+                      << "% to " << cmp.change_high * 100.0 << std::noshowpos << "%), p = "
+                      << std::defaultfloat << std::setprecision(4) << cmp.p_value << "\n";
+            if (cmp.significant && cmp.change > 0.0) {
+                std::cout << "REGRESSION: " << algorithm << " on " << tileset_name << " is significantly slower (alpha "
+                          << alpha << ", min change " << min_change * 100.0 << "%)\n";
+                return 2;
+            }
+            if (cmp.significant)
+                std::cout << "Significant improvement\n";
+            else if (cmp.p_value < alpha)
+                std::cout << "No significant change (below --min-change of " << min_change * 100.0 << "%)\n";
+            else
+                std::cout << "No significant change\n";
+        }
+    }
+
     return 0;
-}
\ No newline at end of file
+}
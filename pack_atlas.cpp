@@ -0,0 +1,21 @@
+#include "Atlas.hpp"
+#include <iostream>
+#include <string>
+
+// Packs a tileset folder into a binary atlas that main loads in place of the folder:
+//   pack_atlas Carcassonne Carcassonne.atlas
+int main(int argc, char const *argv[])
+{
+    if (argc < 2 || argc > 3) {
+        std::cout << "Usage: pack_atlas <pasta> [arquivo.atlas]\n";
+        std::cout << "Exemplo: pack_atlas Carcassonne Carcassonne.atlas\n";
+        return 1;
+    }
+
+    std::string folder = argv[1];
+    while (folder.size() > 1 && (folder.back() == '/' || folder.back() == '\\'))
+        folder.pop_back();
+    std::string output = argc == 3 ? argv[2] : folder + ".atlas";
+
+    return Atlas::pack(folder, output) ? 0 : 1;
+}
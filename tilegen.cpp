@@ -0,0 +1,37 @@
+#include "SyntheticTileset.hpp"
+#include <iostream>
+#include <string>
+
+// Writes a synthetic tileset as a PNG folder that main, bench and pack_atlas load like the bundled ones:
+//   tilegen Sintetico2000 --tiles=2000 --labels=16 --skew=1 --hardness=0.2 --seed=1 --size=8
+int main(int argc, char const *argv[])
+{
+    SyntheticTileset synthetic;
+    std::string folder;
+    std::string spec;
+    int tile_size = 8;
+    bool valid = argc >= 2;
+    for (int i = 1; i < argc && valid; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0) {
+            valid = folder.empty();
+            folder = arg;
+        } else if (eq == std::string::npos) {
+            valid = false;
+        } else if (arg.compare(2, eq - 2, "size") == 0) {
+            tile_size = std::stoi(arg.substr(eq + 1));
+        } else {
+            spec += ":" + arg.substr(2);
+        }
+    }
+    if (!valid || folder.empty() || tile_size < 1) {
+        std::cout << "Usage: tilegen <pasta> [--tiles=N] [--labels=N] [--skew=S] [--hardness=H] [--seed=N] [--size=px]\n";
+        std::cout << "Exemplo: tilegen Sintetico2000 --tiles=2000 --labels=16 --skew=1 --hardness=0.2\n";
+        return 1;
+    }
+
+    if (!synthetic.parse(spec))
+        return 1;
+    return synthetic.write_folder(folder, tile_size) ? 0 : 1;
+}